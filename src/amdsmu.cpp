@@ -21,6 +21,8 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "amdsmu.h"
 #include "pci.h"
 #include "common.h"
+#include "trace.h"
+#include "stats.h"
 
 #include <map>
 #include <fcntl.h>
@@ -198,6 +200,7 @@ static void _pci_reg_wr(pci_dev* dev, uint32_t addr, uint32_t data){
 
 uint32_t _smu_amd_send_req(smu_amd* smu, uint32_t msg, uint32_t* args){
     uint32_t res = 0;
+    uint64_t start = trace_clock();
 
     _pci_reg_wr(smu->dev, smu->res, 0);
 
@@ -213,6 +216,14 @@ uint32_t _smu_amd_send_req(smu_amd* smu, uint32_t msg, uint32_t* args){
     args[0] = _pci_reg_rd(smu->dev, MSG_ARG_ADDR(smu->arg_base, 0));
     args[1] = _pci_reg_rd(smu->dev, MSG_ARG_ADDR(smu->arg_base, 1));
 
+    /* whole mailbox round trip, config space accesses nest under it. Status is SMU response, 1 is OK */
+    if(timeline_enabled()){
+        char detail[16];
+
+        snprintf(detail, sizeof(detail), "%x", msg);
+        timeline_span(TIMELINE_CAT_SMU, "message", detail, start, trace_clock() - start, res);
+    }
+
     return res;
 }
 
@@ -222,20 +233,76 @@ void** get_phys_map(){
     return &phys_map;
 }
 
+/* physical address currently mapped, page is traced when unmapped */
+static uintptr_t phys_addr = 0;
+
+static std::string _map_trace_key(uintptr_t addr){
+    char key[32];
+
+    snprintf(key, sizeof(key), "%lx", (unsigned long)addr);
+
+    return key;
+}
+
+/* maps an anonymous page holding recorded contents of addr */
+static int _map_replay_addr(uintptr_t addr){
+    std::string page;
+    int32_t status;
+
+    if(!trace_replay(TRACE_OP_MEM, _map_trace_key(addr).c_str(), &status, &page)){
+        return ENOENT;
+    }
+
+    if(status != 0){
+        return status;
+    }
+
+    phys_map = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(phys_map == MAP_FAILED){
+        return errno;
+    }
+
+    page.copy((char*)phys_map, 4096);
+
+    return 0;
+}
+
 int _map_dev_addr(uintptr_t addr){
+    int mode = trace_mode();
+
+    if(mode == TRACE_REPLAY){
+        return _map_replay_addr(addr);
+    }
+
+    uint64_t start = trace_clock();
     int dev_fd = open("/dev/mem", O_RDONLY);
     int dev_errno = errno;
 
+    stats_syscalls(1);
+
     if(dev_fd > 0){
         phys_map = mmap(NULL, 4096, PROT_READ, MAP_SHARED, dev_fd, addr);
         int map_errno = errno;
         close(dev_fd);
+        stats_syscalls(2);
 
         if (phys_map == MAP_FAILED) {
-            return map_errno;
+            dev_errno = map_errno;
+        }
+        else {
+            phys_addr = addr;
+            dev_errno = 0;
         }
+    }
 
-        return 0;
+    /* successful maps are recorded with their contents once unmapped */
+    if(mode == TRACE_RECORD and dev_errno != 0){
+        trace_record(TRACE_OP_MEM, _map_trace_key(addr).c_str(), dev_errno, nullptr, 0, trace_clock() - start);
+    }
+
+    if(timeline_enabled()){
+        timeline_access(TRACE_OP_MEM, _map_trace_key(addr).c_str(), start, trace_clock() - start, dev_errno);
     }
 
     return dev_errno;
@@ -243,7 +310,13 @@ int _map_dev_addr(uintptr_t addr){
 
 void _free_map_dev(){
     if(phys_map != MAP_FAILED){
+        /* page is only read by now, so a single snapshot replays it */
+        if(trace_mode() == TRACE_RECORD){
+            trace_record(TRACE_OP_MEM, _map_trace_key(phys_addr).c_str(), 0, (const void*)phys_map, 4096, 0);
+        }
+
         munmap((void*)phys_map, 4096);
+        stats_syscalls(1);
     }
 }
 
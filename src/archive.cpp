@@ -0,0 +1,258 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "archive.h"
+
+#include <zlib.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+#define TAR_BLOCK 512
+
+/* deflate output buffer */
+#define ARCHIVE_CHUNK (64 * 1024)
+
+struct archive_t
+{
+    int fd;
+    int status;
+    bool closing;
+
+    mutex lock;
+    condition_variable wake;
+    deque<string> queue;
+
+    thread worker;
+};
+
+/* ustar header, all numbers are zero padded octal strings */
+struct tar_header_t
+{
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char type;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char pad[12];
+};
+
+static_assert(sizeof(tar_header_t) == TAR_BLOCK, "bad tar header size");
+
+static int write_all(int fd, const unsigned char* data, size_t size)
+{
+    while (size > 0) {
+        ssize_t len = write(fd, data, size);
+
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        data += len;
+        size -= len;
+    }
+
+    return 0;
+}
+
+static void archive_compress(archive_t* archive)
+{
+    z_stream strm;
+    unsigned char out[ARCHIVE_CHUNK];
+    int status = 0;
+
+    memset(&strm, 0, sizeof(strm));
+
+    /* 16 on top of window bits asks zlib for a gzip wrapper */
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        status = ENOMEM;
+    }
+
+    bool finished = false;
+
+    while (!finished) {
+        string chunk;
+
+        {
+            unique_lock<mutex> guard(archive->lock);
+
+            archive->wake.wait(guard, [archive]() {
+                return archive->closing or archive->queue.size() > 0;
+            });
+
+            if (archive->queue.size() > 0) {
+                chunk = std::move(archive->queue.front());
+                archive->queue.pop_front();
+            }
+            else {
+                finished = true;
+            }
+        }
+
+        /* keep draining after an error, so producer never blocks on us */
+        if (status != 0) {
+            continue;
+        }
+
+        strm.next_in = (Bytef*)chunk.data();
+        strm.avail_in = chunk.size();
+
+        int flush = finished ? Z_FINISH : Z_NO_FLUSH;
+
+        do {
+            strm.next_out = out;
+            strm.avail_out = sizeof(out);
+
+            deflate(&strm, flush);
+
+            status = write_all(archive->fd, out, sizeof(out) - strm.avail_out);
+        } while (status == 0 and strm.avail_out == 0);
+    }
+
+    deflateEnd(&strm);
+
+    lock_guard<mutex> guard(archive->lock);
+    archive->status = status;
+}
+
+static void push(archive_t* archive, string data)
+{
+    lock_guard<mutex> guard(archive->lock);
+
+    archive->queue.push_back(std::move(data));
+    archive->wake.notify_one();
+}
+
+archive_t* archive_open(const char* path, int* status)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        *status = errno;
+        return nullptr;
+    }
+
+    archive_t* archive = new archive_t();
+
+    archive->fd = fd;
+    archive->status = 0;
+    archive->closing = false;
+    archive->worker = thread(archive_compress, archive);
+
+    *status = 0;
+
+    return archive;
+}
+
+int archive_add(archive_t* archive, const string& name, string data, time_t mtime)
+{
+    tar_header_t header;
+
+    if (name.size() >= sizeof(header.name)) {
+        return ENAMETOOLONG;
+    }
+
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.name, name.c_str(), name.size());
+    snprintf(header.mode, sizeof(header.mode), "%07o", 0644);
+    snprintf(header.uid, sizeof(header.uid), "%07o", 0);
+    snprintf(header.gid, sizeof(header.gid), "%07o", 0);
+    snprintf(header.size, sizeof(header.size), "%011llo", (unsigned long long)data.size());
+    snprintf(header.mtime, sizeof(header.mtime), "%011llo", (unsigned long long)mtime);
+    header.type = '0';
+    memcpy(header.magic, "ustar", 6);
+    memcpy(header.version, "00", 2);
+    strcpy(header.uname, "root");
+    strcpy(header.gname, "root");
+
+    /* checksum is computed with its own field filled with spaces */
+    memset(header.checksum, ' ', sizeof(header.checksum));
+
+    unsigned int sum = 0;
+
+    for (size_t n = 0; n < sizeof(header); n++) {
+        sum += ((unsigned char*)&header)[n];
+    }
+
+    snprintf(header.checksum, sizeof(header.checksum), "%06o", sum);
+
+    push(archive, string((char*)&header, sizeof(header)));
+
+    size_t padding = (TAR_BLOCK - data.size() % TAR_BLOCK) % TAR_BLOCK;
+
+    data.append(padding, '\0');
+    push(archive, std::move(data));
+
+    return 0;
+}
+
+int archive_close(archive_t* archive)
+{
+    /* end of archive is two zero blocks */
+    push(archive, string(TAR_BLOCK * 2, '\0'));
+
+    {
+        lock_guard<mutex> guard(archive->lock);
+        archive->closing = true;
+        archive->wake.notify_one();
+    }
+
+    archive->worker.join();
+
+    int status = archive->status;
+
+    if (fsync(archive->fd) < 0 and status == 0) {
+        status = errno;
+    }
+
+    if (close(archive->fd) < 0 and status == 0) {
+        status = errno;
+    }
+
+    delete archive;
+
+    return status;
+}
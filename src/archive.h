@@ -0,0 +1,41 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_ARCHIVE_H
+#define SLB_ARCHIVE_H
+
+#include <string>
+#include <ctime>
+
+struct archive_t;
+
+/*
+  Creates a gzip compressed tar at path, which must not exist. Compression
+  runs on its own thread while entries are being added
+*/
+archive_t* archive_open(const char* path, int* status);
+
+/* Queues a regular file entry, data is moved into the archive */
+int archive_add(archive_t* archive, const std::string& name, std::string data, time_t mtime);
+
+/* Writes tar trailer, waits for compression to finish and frees archive */
+int archive_close(archive_t* archive);
+
+#endif
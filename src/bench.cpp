@@ -0,0 +1,449 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "bench.h"
+#include "slimbook.h"
+#include "common.h"
+#include "telemetry.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <new>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+using namespace std;
+
+/* from slimbook.cpp, cleared so detection is measured and not its cache */
+extern bool info_cached;
+
+static std::atomic<uint64_t> bench_allocs(0);
+
+/*
+  Counts every C++ heap allocation in this process, library included, as
+  its operator new calls resolve here. Other forms end up calling this one
+*/
+void* operator new(size_t size)
+{
+    bench_allocs.fetch_add(1, std::memory_order_relaxed);
+
+    void* ptr = malloc(size ? size : 1);
+
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+typedef int (*bench_proc)();
+
+typedef struct bench_call_t {
+    const char* name;
+    bench_proc call;
+    /* other threads running same call while it is measured */
+    int threads;
+} bench_call_t;
+
+typedef struct bench_result_t {
+    string name;
+    uint64_t iterations;
+    uint64_t p50;
+    uint64_t p99;
+    double syscalls;
+    double allocs;
+    int status;
+} bench_result_t;
+
+static const bench_call_t calls[] = {
+    {"slb_info_retrieve", []() { info_cached = false; return (int)slb_info_retrieve(); }, 0},
+    {"slb_info_get_model", []() { return (int)(slb_info_get_model() == 0); }, 0},
+    {"slb_info_get_platform", []() { return (int)(slb_info_get_platform() == 0); }, 0},
+    {"slb_info_is_module_loaded", []() { return (int)(slb_info_is_module_loaded() == 0); }, 0},
+    {"slb_info_uptime", []() { return (int)(slb_info_uptime() < 0); }, 0},
+    {"slb_info_kernel", []() { return (int)(slb_info_kernel() == nullptr); }, 0},
+    {"slb_info_cmdline", []() { return (int)(slb_info_cmdline() == nullptr); }, 0},
+    {"slb_info_total_memory", []() { return (int)(slb_info_total_memory() == 0); }, 0},
+    {"slb_info_available_memory", []() { return (int)(slb_info_available_memory() == 0); }, 0},
+    {"slb_info_get_tdp_info", []() { slb_tdp_info_t tdp = slb_info_get_tdp_info(); return (int)(tdp.slow == 0); }, 0},
+    {"slb_info_keyboard_device", []() { return (int)(slb_info_keyboard_device() == nullptr); }, 0},
+    {"slb_info_module_device", []() { return (int)(slb_info_module_device() == nullptr); }, 0},
+    {"slb_info_touchpad_device", []() { return (int)(slb_info_touchpad_device() == nullptr); }, 0},
+    {"slb_info_get_ac_state", []() { int state; return (int)slb_info_get_ac_state(0, &state); }, 0},
+    {"slb_smbios_get", []() {
+        slb_smbios_entry_t* entries = nullptr;
+        int count = 0;
+        int status = slb_smbios_get(&entries, &count);
+
+        if (status == 0) {
+            slb_smbios_free(entries);
+        }
+
+        return status;
+    }, 0},
+    {"slb_battery_info_get", []() { slb_sys_battery_info info; return slb_battery_info_get(&info); }, 0},
+    {"slb_kbd_backlight_get", []() { uint32_t v; return slb_kbd_backlight_get(0, &v); }, 0},
+    {"slb_kbd_brightness_get", []() { uint32_t v; return slb_kbd_brightness_get(0, &v); }, 0},
+    {"slb_kbd_brightness_max", []() { uint32_t v; return slb_kbd_brightness_max(0, &v); }, 0},
+    {"slb_profile_capture", []() { slb_profile_t profile; return slb_profile_capture(&profile); }, 0},
+    {"slb_qc71_manual_control_get", []() { uint32_t v; return slb_qc71_manual_control_get(&v); }, 0},
+    {"slb_qc71_fn_lock_get", []() { uint32_t v; return slb_qc71_fn_lock_get(&v); }, 0},
+    {"slb_qc71_super_lock_get", []() { uint32_t v; return slb_qc71_super_lock_get(&v); }, 0},
+    {"slb_qc71_silent_mode_get", []() { uint32_t v; return slb_qc71_silent_mode_get(&v); }, 0},
+    {"slb_qc71_turbo_mode_get", []() { uint32_t v; return slb_qc71_turbo_mode_get(&v); }, 0},
+    {"slb_qc71_profile_get", []() { uint32_t v; return slb_qc71_profile_get(&v); }, 0},
+    {"slb_qc71_custom_tdp_get", []() { uint32_t a, b, c; return slb_qc71_custom_tdp_get(&a, &b, &c); }, 0},
+    {"slb_qc71_primary_fan_get", []() { uint32_t v; return slb_qc71_primary_fan_get(&v); }, 0},
+    {"slb_qc71_secondary_fan_get", []() { uint32_t v; return slb_qc71_secondary_fan_get(&v); }, 0},
+    {"slb_clevo_primary_fan_get", []() { uint32_t v; return slb_clevo_primary_fan_get(&v); }, 0},
+    {"slb_clevo_secondary_fan_get", []() { uint32_t v; return slb_clevo_secondary_fan_get(&v); }, 0},
+    {"slb_telemetry_read", []() { slb_telemetry_t telemetry; return slb_telemetry_read(&telemetry); }, 0},
+    {"slb_telemetry_read_4_readers", []() { slb_telemetry_t telemetry; return slb_telemetry_read(&telemetry); }, 3},
+    /* shared parsing layer, a miss is the expected error and not an exception */
+    {"parse_u32_hit", []() { uint32_t v; return parse_u32("2350", &v); }, 0},
+    {"parse_u32_miss", []() { uint32_t v; return (int)(parse_u32("n/a", &v) != EINVAL); }, 0},
+    {"format_u32", []() { char buf[SLB_DEVICE_BUFFER_SIZE]; return (int)(format_u32(buf, sizeof(buf), 0xff8000, 16, 6) != 6); }, 0},
+    {"read_device_u32_hit", []() { uint32_t v; return read_device_u32("/sys/class/power_supply/BAT0/capacity", &v); }, 0},
+    {"read_device_u32_miss", []() { uint32_t v; return (int)(read_device_u32("/sys/class/power_supply/BAT9/capacity", &v) != ENOENT); }, 0},
+    {nullptr, nullptr, 0}
+};
+
+static uint64_t monotonic_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* perf counter of syscalls entered by this thread, -1 when not available */
+static int syscall_counter_open()
+{
+    const char* paths[] = {
+        "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id",
+        nullptr
+    };
+
+    for (int n = 0; paths[n]; n++) {
+        ifstream file(paths[n]);
+        uint64_t id;
+
+        if (!(file >> id)) {
+            continue;
+        }
+
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = id;
+
+        return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+
+    return -1;
+}
+
+static uint64_t syscall_counter_read(int fd)
+{
+    uint64_t value = 0;
+
+    if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+        return 0;
+    }
+
+    return value;
+}
+
+static void bench_background(bench_proc call, atomic<bool>* stop)
+{
+    while (!stop->load(std::memory_order_relaxed)) {
+        call();
+    }
+}
+
+/* publishes far more often than slimbookd does, so readers have to retry */
+static void bench_publisher(atomic<bool>* stop)
+{
+    slb_telemetry_t telemetry;
+    struct timespec pause = {0, BENCH_PUBLISH_US * 1000};
+
+    memset(&telemetry, 0, sizeof(telemetry));
+    telemetry.valid = SLB_TELEMETRY_BATTERY;
+
+    while (!stop->load(std::memory_order_relaxed)) {
+        telemetry.battery_capacity++;
+        telemetry_publish(&telemetry);
+        nanosleep(&pause, nullptr);
+    }
+}
+
+static bench_result_t bench_call(const bench_call_t& call, int counter)
+{
+    bench_result_t result = {call.name, 0, 0, 0, -1, 0, 0};
+    vector<uint64_t> samples;
+
+    /* warm up, so one time setup does not count */
+    result.status = call.call();
+
+    uint64_t deadline = monotonic_ns() + BENCH_TIME_MS * 1000000ull;
+    uint64_t allocs = bench_allocs.load(std::memory_order_relaxed);
+    uint64_t syscalls = counter >= 0 ? syscall_counter_read(counter) : 0;
+
+    samples.reserve(BENCH_MAX_ITERATIONS);
+
+    while (samples.size() < BENCH_MAX_ITERATIONS) {
+        uint64_t start = monotonic_ns();
+        call.call();
+        uint64_t end = monotonic_ns();
+
+        samples.push_back(end - start);
+
+        if (end > deadline and samples.size() >= BENCH_MIN_ITERATIONS) {
+            break;
+        }
+    }
+
+    result.iterations = samples.size();
+
+    /* last read is itself a syscall */
+    if (counter >= 0) {
+        result.syscalls = (double)(syscall_counter_read(counter) - syscalls - 1) / result.iterations;
+    }
+
+    result.allocs = (double)(bench_allocs.load(std::memory_order_relaxed) - allocs) / result.iterations;
+
+    std::sort(samples.begin(), samples.end());
+    result.p50 = samples[samples.size() / 2];
+    result.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+
+    return result;
+}
+
+static string json_value(const string& line, const string& key)
+{
+    string pattern = "\"" + key + "\":";
+    size_t pos = line.find(pattern);
+
+    if (pos == string::npos) {
+        return "";
+    }
+
+    pos += pattern.size();
+    size_t end = line.find_first_of(",}", pos);
+
+    string value = line.substr(pos, end - pos);
+    value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+
+    return value;
+}
+
+/* reads results written with json, one call per line */
+static int load_baseline(const string& path, map<string, bench_result_t>& baseline)
+{
+    ifstream file(path);
+
+    if (!file.good()) {
+        return ENOENT;
+    }
+
+    string line;
+
+    while (std::getline(file, line)) {
+        string name = json_value(line, "name");
+
+        if (name.empty()) {
+            continue;
+        }
+
+        bench_result_t& result = baseline[name];
+        result.name = name;
+        result.p50 = std::strtoull(json_value(line, "p50_ns").c_str(), nullptr, 10);
+        result.p99 = std::strtoull(json_value(line, "p99_ns").c_str(), nullptr, 10);
+        result.syscalls = std::strtod(json_value(line, "syscalls").c_str(), nullptr);
+        result.allocs = std::strtod(json_value(line, "allocs").c_str(), nullptr);
+    }
+
+    return 0;
+}
+
+static string fixed(double value)
+{
+    stringstream stream;
+    stream.precision(1);
+    stream<<std::fixed<<value;
+
+    return stream.str();
+}
+
+int bench_run(const vector<string>& filters, bool json, const string& baseline)
+{
+    map<string, bench_result_t> base;
+
+    if (!baseline.empty()) {
+        int status = load_baseline(baseline, base);
+
+        if (status != 0) {
+            cerr<<"Failed to read baseline "<<baseline<<":"<<status<<endl;
+            return status;
+        }
+    }
+
+    int counter = syscall_counter_open();
+    int ret = 0;
+
+    /* a fixture tree has no slimbookd, so telemetry is published from here */
+    bool publishing = false;
+
+    if (root_active()) {
+        std::error_code ec;
+        filesystem::create_directories(root_path(string(SLB_TELEMETRY_DIR)), ec);
+        publishing = telemetry_create() == 0;
+    }
+
+    if (json) {
+        cout<<"[\n";
+    }
+    else {
+        cout<<"call                            p50(ns)    p99(ns)   syscalls  allocs  status\n";
+    }
+
+    bool first = true;
+
+    for (int n = 0; calls[n].name; n++) {
+        bool selected = filters.empty();
+
+        for (const string& filter : filters) {
+            selected = selected or string(calls[n].name).find(filter) != string::npos;
+        }
+
+        if (!selected) {
+            continue;
+        }
+
+        atomic<bool> stop(false);
+        vector<thread> background;
+
+        for (int t = 0; t < calls[n].threads; t++) {
+            background.emplace_back(bench_background, calls[n].call, &stop);
+        }
+
+        if (calls[n].threads > 0 and publishing) {
+            background.emplace_back(bench_publisher, &stop);
+        }
+
+        bench_result_t result = bench_call(calls[n], counter);
+
+        stop = true;
+
+        for (thread& t : background) {
+            t.join();
+        }
+
+        string delta;
+
+        auto old = base.find(result.name);
+
+        if (old != base.end() and old->second.p50 > 0) {
+            double growth = 100.0 * ((double)result.p50 - old->second.p50) / old->second.p50;
+            delta = (growth >= 0 ? "+" : "") + fixed(growth) + "%";
+
+            /* a few ns are just noise on calls served from cache */
+            if (growth > BENCH_REGRESSION and result.p50 - old->second.p50 > 100) {
+                delta += " REGRESSION";
+                ret = BENCH_REGRESSED;
+            }
+
+            if (result.syscalls > old->second.syscalls + 0.5 or result.allocs > old->second.allocs + 0.5) {
+                delta += " MORE-WORK";
+                ret = BENCH_REGRESSED;
+            }
+        }
+
+        if (json) {
+            cout<<(first ? "" : ",\n");
+            cout<<"{\"name\":\""<<result.name<<"\",\"iterations\":"<<result.iterations;
+            cout<<",\"p50_ns\":"<<result.p50<<",\"p99_ns\":"<<result.p99;
+            cout<<",\"syscalls\":"<<fixed(result.syscalls)<<",\"allocs\":"<<fixed(result.allocs);
+            cout<<",\"status\":"<<result.status;
+
+            if (!delta.empty()) {
+                cout<<",\"baseline\":\""<<delta<<"\"";
+            }
+
+            cout<<"}";
+        }
+        else {
+            cout.width(32);
+            cout<<std::left<<result.name<<std::right;
+            cout.width(7);
+            cout<<result.p50<<" ";
+            cout.width(10);
+            cout<<result.p99<<" ";
+            cout.width(10);
+            cout<<fixed(result.syscalls)<<" ";
+            cout.width(7);
+            cout<<fixed(result.allocs)<<" ";
+            cout.width(7);
+            cout<<result.status<<"  "<<delta<<"\n";
+        }
+
+        cout.flush();
+        first = false;
+    }
+
+    if (json) {
+        cout<<"\n]\n";
+    }
+
+    if (counter >= 0) {
+        close(counter);
+    }
+
+    if (publishing) {
+        telemetry_destroy();
+    }
+
+    return ret;
+}
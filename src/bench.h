@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_BENCH_H
+#define SLB_BENCH_H
+
+#include <string>
+#include <vector>
+
+/* time spent on each call before moving to next one */
+#define BENCH_TIME_MS       250
+#define BENCH_MAX_ITERATIONS 100000
+#define BENCH_MIN_ITERATIONS 5
+
+/* telemetry publish period while readers are measured under contention */
+#define BENCH_PUBLISH_US    100
+
+/* p50 growth over baseline, in percent, reported as a regression */
+#define BENCH_REGRESSION    20
+
+/* returned when any call regressed against baseline */
+#define BENCH_REGRESSED     3
+
+/*
+  Runs every read only public library call, and the parsing helpers they
+  share on hit and miss paths, in a tight loop and prints p50/p99 latency,
+  syscalls and operator new allocations per call. Setters are left out,
+  they would touch hardware state. Only calls whose name
+  contains one of filters run, all of them when empty. Syscalls are
+  counted through perf raw_syscalls tracepoint and shown as -1 when it is
+  not available. With a baseline file, as written by a previous run with
+  json, every call is compared against it. Calls with a thread count are
+  measured while other threads run them too, ie: telemetry readers, and
+  against a fixture root telemetry is also being published meanwhile.
+  Returns 0, BENCH_REGRESSED or errno
+*/
+int bench_run(const std::vector<std::string>& filters, bool json, const std::string& baseline);
+
+#endif
@@ -0,0 +1,1058 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "collectors.h"
+#include "common.h"
+#include "pci.h"
+
+#include <sys/utsname.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cerrno>
+
+using namespace std;
+
+#define SYS_BLOCK "/sys/block/"
+#define SYS_USB "/sys/bus/usb/devices/"
+#define SYS_CPU "/sys/devices/system/cpu/"
+
+/* how far back journal goes, as journalctl --since "2 days ago" did */
+#define JOURNAL_SINCE_USEC (2ULL * 24 * 3600 * 1000000)
+#define JOURNAL_MAX_BYTES (64 * 1024 * 1024)
+#define JOURNAL_CRITICAL 2
+
+/* bump when collectors output format changes */
+#define CACHE_VERSION 1
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static const char* pci_ids[] = {"/usr/share/hwdata/pci.ids", "/usr/share/misc/pci.ids", nullptr};
+static const char* usb_ids[] = {"/usr/share/hwdata/usb.ids", "/usr/share/misc/usb.ids", "/var/lib/usbutils/usb.ids", nullptr};
+
+/* names found in a pci.ids/usb.ids style database */
+struct ids_names_t
+{
+    map<uint32_t, string> vendors;
+    /* vendor << 16 | device */
+    map<uint32_t, string> devices;
+    /* class << 8 | subclass, pci.ids only */
+    map<uint32_t, string> classes;
+};
+
+static string read_attr(const string& path)
+{
+    char buf[256];
+
+    if (read_device_buf(path.c_str(), buf, sizeof(buf)) != 0) {
+        return "";
+    }
+
+    return buf;
+}
+
+static string read_text(const string& path)
+{
+    ifstream file(path);
+    stringstream ss;
+
+    ss<<file.rdbuf();
+
+    return ss.str();
+}
+
+/*
+  Loads names for the given vendors from first database found. A single pass
+  over the file, vendors not asked for are skipped
+*/
+static void ids_load(const char** paths, const set<uint32_t>& vendors, ids_names_t& names)
+{
+    ifstream file;
+
+    for (int n = 0; paths[n] and !file.is_open(); n++) {
+        file.open(paths[n]);
+    }
+
+    if (!file.is_open()) {
+        return;
+    }
+
+    string line;
+    uint32_t vendor = 0;
+    bool wanted = false;
+    bool classes = false;
+
+    while (getline(file, line)) {
+        if (line.empty() or line[0] == '#') {
+            continue;
+        }
+
+        uint32_t id;
+        const char* end;
+
+        if (line[0] != '\t') {
+            classes = line[0] == 'C' and line.size() > 2 and line[1] == ' ';
+            wanted = false;
+
+            if (classes) {
+                if (parse_u32(line.c_str() + 2, &id, 16, &end) == 0) {
+                    vendor = id;
+                    names.classes[vendor << 8] = end + strspn(end, " ");
+                }
+            }
+            else if (parse_u32(line.c_str(), &id, 16, &end) == 0 and vendors.count(id) > 0) {
+                vendor = id;
+                wanted = true;
+                names.vendors[vendor] = end + strspn(end, " ");
+            }
+
+            continue;
+        }
+
+        /* second tab level is subsystems or programming interfaces */
+        if (line.size() < 2 or line[1] == '\t' or !(wanted or classes)) {
+            continue;
+        }
+
+        if (parse_u32(line.c_str() + 1, &id, 16, &end) != 0) {
+            continue;
+        }
+
+        if (classes) {
+            names.classes[vendor << 8 | id] = end + strspn(end, " ");
+        }
+        else {
+            names.devices[vendor << 16 | id] = end + strspn(end, " ");
+        }
+    }
+}
+
+static string ids_find(const map<uint32_t, string>& names, uint32_t key, const string& fallback)
+{
+    auto it = names.find(key);
+
+    return it != names.end() ? it->second : fallback;
+}
+
+/* binary units, as free -h and lsblk print them */
+static string human_size(uint64_t value, bool binary_suffix)
+{
+    const char* units[] = {"B", "K", "M", "G", "T", "P"};
+    double tmp = value;
+    int unit = 0;
+
+    while (tmp >= 1024 and unit < 5) {
+        tmp /= 1024;
+        unit++;
+    }
+
+    char buf[32];
+
+    if (unit == 0) {
+        snprintf(buf, sizeof(buf), "%luB", (unsigned long)value);
+    }
+    else {
+        snprintf(buf, sizeof(buf), tmp < 10 ? "%.1f%s%s" : "%.0f%s%s", tmp, units[unit], binary_suffix ? "i" : "");
+    }
+
+    return buf;
+}
+
+/* expands a cpu list as "0-3,8" into its count */
+static int cpu_list_count(const string& list)
+{
+    int count = 0;
+    const char* str = list.c_str();
+
+    while (*str) {
+        uint32_t first;
+        uint32_t last;
+
+        if (parse_u32(str, &first, 10, &str) != 0) {
+            break;
+        }
+
+        last = first;
+
+        if (*str == '-') {
+            parse_u32(str + 1, &last, 10, &str);
+        }
+
+        count += last - first + 1;
+
+        if (*str == ',') {
+            str++;
+        }
+        else {
+            break;
+        }
+    }
+
+    return count;
+}
+
+static int collect_date(collector_output_t& out)
+{
+    char buf[64];
+    time_t now = time(nullptr);
+    tm local;
+
+    localtime_r(&now, &local);
+    strftime(buf, sizeof(buf), "%a %b %e %H:%M:%S %Z %Y\n", &local);
+
+    out.text = buf;
+
+    return 0;
+}
+
+static int collect_mem(collector_output_t& out)
+{
+    map<string, uint64_t> meminfo;
+    istringstream in(read_text("/proc/meminfo"));
+    string line;
+
+    while (getline(in, line)) {
+        size_t colon = line.find(':');
+        uint32_t kb;
+
+        if (colon != string::npos and parse_u32(line.c_str() + colon + 1, &kb) == 0) {
+            meminfo[line.substr(0, colon)] = (uint64_t)kb * 1024;
+        }
+    }
+
+    if (meminfo.count("MemTotal") == 0) {
+        return ENOENT;
+    }
+
+    uint64_t total = meminfo["MemTotal"];
+    uint64_t available = meminfo.count("MemAvailable") ? meminfo["MemAvailable"] : meminfo["MemFree"];
+    uint64_t cache = meminfo["Buffers"] + meminfo["Cached"] + meminfo["SReclaimable"];
+    uint64_t swap_total = meminfo["SwapTotal"];
+    uint64_t swap_free = meminfo["SwapFree"];
+
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "%-7s%12s%12s%12s%12s%12s%12s\n", "", "total", "used", "free", "shared", "buff/cache", "available");
+    out.text = buf;
+
+    snprintf(buf, sizeof(buf), "%-7s%12s%12s%12s%12s%12s%12s\n", "Mem:",
+             human_size(total, true).c_str(),
+             human_size(total - available, true).c_str(),
+             human_size(meminfo["MemFree"], true).c_str(),
+             human_size(meminfo["Shmem"], true).c_str(),
+             human_size(cache, true).c_str(),
+             human_size(available, true).c_str());
+    out.text += buf;
+
+    snprintf(buf, sizeof(buf), "%-7s%12s%12s%12s\n", "Swap:",
+             human_size(swap_total, true).c_str(),
+             human_size(swap_total - swap_free, true).c_str(),
+             human_size(swap_free, true).c_str());
+    out.text += buf;
+
+    return 0;
+}
+
+static void blk_line(string& out, const string& prefix, const string& name, const string& path, const string& type, map<string, string>& mounts)
+{
+    uint32_t removable = 0;
+    uint32_t ro = 0;
+    /* size is in 512 byte sectors, and may not fit in 32 bits */
+    string size = read_attr(path + "size");
+
+    read_device_u32((path + "removable").c_str(), &removable);
+    read_device_u32((path + "ro").c_str(), &ro);
+
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "%-16s %-7s %2u %7s %2u %-5s %s\n",
+             (prefix + name).c_str(),
+             read_attr(path + "dev").c_str(),
+             removable,
+             human_size(strtoull(size.c_str(), nullptr, 10) * 512, false).c_str(),
+             ro,
+             type.c_str(),
+             mounts[name].c_str());
+
+    out += buf;
+}
+
+static int collect_blk(collector_output_t& out)
+{
+    map<string, string> mounts;
+    istringstream in(read_text("/proc/self/mounts"));
+    string line;
+
+    while (getline(in, line)) {
+        istringstream fields(line);
+        string source;
+        string target;
+
+        fields>>source>>target;
+
+        if (source.compare(0, 5, "/dev/") == 0) {
+            string& m = mounts[source.substr(5)];
+            m += (m.empty() ? "" : ",") + target;
+        }
+    }
+
+    istringstream swaps(read_text("/proc/swaps"));
+
+    while (getline(swaps, line)) {
+        if (line.compare(0, 5, "/dev/") == 0) {
+            mounts[line.substr(5, line.find_first_of(" \t") - 5)] = "[SWAP]";
+        }
+    }
+
+    vector<string> disks;
+    error_code ec;
+
+    for (const auto& entry : filesystem::directory_iterator(SYS_BLOCK, ec)) {
+        disks.push_back(entry.path().filename().string());
+    }
+
+    if (ec) {
+        return ec.value();
+    }
+
+    sort(disks.begin(), disks.end());
+
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "%-16s %-7s %2s %7s %2s %-5s %s\n", "NAME", "MAJ:MIN", "RM", "SIZE", "RO", "TYPE", "MOUNTPOINTS");
+    out.text = buf;
+
+    for (const string& disk : disks) {
+        string path = SYS_BLOCK + disk + "/";
+        string type = "disk";
+
+        if (disk.compare(0, 4, "loop") == 0) {
+            /* unused loop devices are just noise */
+            if (read_attr(path + "size") == "0") {
+                continue;
+            }
+
+            type = "loop";
+        }
+        else if (disk.compare(0, 2, "sr") == 0) {
+            type = "rom";
+        }
+        else if (disk.compare(0, 3, "dm-") == 0) {
+            type = "dm";
+        }
+
+        blk_line(out.text, "", disk, path, type, mounts);
+
+        vector<string> parts;
+
+        for (const auto& entry : filesystem::directory_iterator(path, ec)) {
+            if (filesystem::exists(entry.path() / "partition")) {
+                parts.push_back(entry.path().filename().string());
+            }
+        }
+
+        sort(parts.begin(), parts.end());
+
+        for (size_t n = 0; n < parts.size(); n++) {
+            blk_line(out.text, n + 1 < parts.size() ? "├─" : "└─", parts[n], path + parts[n] + "/", "part", mounts);
+        }
+    }
+
+    return 0;
+}
+
+static int collect_pci(collector_output_t& out)
+{
+    pci_access* a = pci_access_alloc();
+
+    if (a == nullptr) {
+        return ENOMEM;
+    }
+
+    pci_init_dev(a);
+
+    vector<pci_device_info> devices;
+    int status = pci_enumerate(a, devices);
+
+    /* pci_cleanup is the only way to release an access, and it wants a device */
+    pci_dev* dev = pci_get_dev(a, 0, 0, 0, 0);
+
+    if (dev) {
+        pci_cleanup(dev);
+    }
+    else {
+        free(a);
+    }
+
+    if (status != 0) {
+        return status;
+    }
+
+    set<uint32_t> vendors;
+
+    for (pci_device_info& d : devices) {
+        vendors.insert(d.vendor);
+        vendors.insert(d.subsystem_vendor);
+    }
+
+    ids_names_t names;
+    ids_load(pci_ids, vendors, names);
+
+    for (pci_device_info& d : devices) {
+        char buf[512];
+        uint32_t cls = d.class_code >> 8;
+        string cls_name = ids_find(names.classes, cls, ids_find(names.classes, cls & 0xff00, "Class"));
+        string vendor = ids_find(names.vendors, d.vendor, "Device");
+        string device = ids_find(names.devices, (uint32_t)d.vendor << 16 | d.device, "Device");
+
+        if (d.dom != 0) {
+            snprintf(buf, sizeof(buf), "%04x:", d.dom);
+            out.text += buf;
+        }
+
+        snprintf(buf, sizeof(buf), "%02x:%02x.%d %s [%04x]: %s %s [%04x:%04x]",
+                 d.bus, d.dev, d.fun, cls_name.c_str(), cls, vendor.c_str(), device.c_str(), d.vendor, d.device);
+        out.text += buf;
+
+        if (d.revision != 0) {
+            snprintf(buf, sizeof(buf), " (rev %02x)", d.revision);
+            out.text += buf;
+        }
+
+        out.text += "\n";
+
+        if (d.subsystem_vendor != 0) {
+            snprintf(buf, sizeof(buf), "\tSubsystem: %s [%04x:%04x]\n",
+                     ids_find(names.vendors, d.subsystem_vendor, "Device").c_str(), d.subsystem_vendor, d.subsystem_device);
+            out.text += buf;
+        }
+
+        if (!d.driver.empty()) {
+            out.text += "\tKernel driver in use: " + d.driver + "\n";
+        }
+    }
+
+    return 0;
+}
+
+struct usb_device_t
+{
+    uint32_t bus;
+    uint32_t dev;
+    uint32_t vendor;
+    uint32_t product;
+    string manufacturer;
+    string name;
+};
+
+static int collect_usb(collector_output_t& out)
+{
+    vector<usb_device_t> devices;
+    set<uint32_t> vendors;
+    error_code ec;
+
+    for (const auto& entry : filesystem::directory_iterator(SYS_USB, ec)) {
+        string path = entry.path().string() + "/";
+        usb_device_t d;
+
+        /* interfaces have no bus number */
+        if (read_device_u32((path + "busnum").c_str(), &d.bus) != 0 or
+            read_device_u32((path + "devnum").c_str(), &d.dev) != 0 or
+            read_device_u32((path + "idVendor").c_str(), &d.vendor, 16) != 0 or
+            read_device_u32((path + "idProduct").c_str(), &d.product, 16) != 0) {
+            continue;
+        }
+
+        d.manufacturer = read_attr(path + "manufacturer");
+        d.name = read_attr(path + "product");
+
+        vendors.insert(d.vendor);
+        devices.push_back(d);
+    }
+
+    if (ec) {
+        return COLLECTOR_NOT_APPLICABLE;
+    }
+
+    sort(devices.begin(), devices.end(), [](const usb_device_t& x, const usb_device_t& y) {
+        return x.bus != y.bus ? x.bus < y.bus : x.dev < y.dev;
+    });
+
+    ids_names_t names;
+    ids_load(usb_ids, vendors, names);
+
+    for (usb_device_t& d : devices) {
+        char buf[512];
+        string vendor = ids_find(names.vendors, d.vendor, d.manufacturer);
+        string product = ids_find(names.devices, d.vendor << 16 | d.product, d.name);
+
+        snprintf(buf, sizeof(buf), "Bus %03u Device %03u: ID %04x:%04x %s %s\n",
+                 d.bus, d.dev, d.vendor, d.product, vendor.c_str(), product.c_str());
+        out.text += buf;
+    }
+
+    return 0;
+}
+
+static int collect_cpu(collector_output_t& out)
+{
+    stringstream ss;
+    utsname uts;
+
+    if (uname(&uts) == 0) {
+        ss<<"Architecture: "<<uts.machine<<"\n";
+    }
+
+    string online = read_attr(SYS_CPU "online");
+
+    ss<<"CPU(s): "<<cpu_list_count(online)<<"\n";
+    ss<<"On-line CPU(s) list: "<<online<<"\n";
+
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t regs[4];
+    char vendor[13];
+    char brand[49];
+
+    cpuid(0, regs);
+    memcpy(vendor, &regs[1], 4);
+    memcpy(vendor + 4, &regs[3], 4);
+    memcpy(vendor + 8, &regs[2], 4);
+    vendor[12] = 0;
+
+    ss<<"Vendor ID: "<<vendor<<"\n";
+
+    cpuid(0x80000000, regs);
+
+    if (regs[0] >= 0x80000004) {
+        for (uint32_t n = 0; n < 3; n++) {
+            cpuid(0x80000002 + n, regs);
+            memcpy(brand + n * 16, regs, 16);
+        }
+
+        brand[48] = 0;
+
+        const char* name = brand + strspn(brand, " ");
+
+        ss<<"Model name: "<<name<<"\n";
+    }
+
+    cpuid(1, regs);
+
+    uint32_t family = (regs[0] >> 8) & 0xf;
+    uint32_t model = (regs[0] >> 4) & 0xf;
+
+    /* extended fields only count for these, as documented by both vendors */
+    if (family == 0xf) {
+        family += (regs[0] >> 20) & 0xff;
+    }
+
+    if (family == 0x6 or family >= 0xf) {
+        model |= ((regs[0] >> 16) & 0xf) << 4;
+    }
+
+    ss<<"CPU family: "<<family<<"\n";
+    ss<<"Model: "<<model<<"\n";
+    ss<<"Stepping: "<<(regs[0] & 0xf)<<"\n";
+#endif
+
+    set<pair<uint32_t, uint32_t>> cores;
+    set<uint32_t> sockets;
+
+    for (uint32_t cpu = 0; cpu < 4096; cpu++) {
+        string topology = SYS_CPU "cpu" + to_string(cpu) + "/topology/";
+        uint32_t package;
+        uint32_t core;
+
+        if (read_device_u32((topology + "physical_package_id").c_str(), &package) != 0 or
+            read_device_u32((topology + "core_id").c_str(), &core) != 0) {
+            if (!filesystem::exists(SYS_CPU "cpu" + to_string(cpu))) {
+                break;
+            }
+
+            /* offline */
+            continue;
+        }
+
+        cores.insert({package, core});
+        sockets.insert(package);
+    }
+
+    if (sockets.size() > 0) {
+        ss<<"Thread(s) per core: "<<cpu_list_count(read_attr(SYS_CPU "cpu0/topology/thread_siblings_list"))<<"\n";
+        ss<<"Core(s) per socket: "<<cores.size() / sockets.size()<<"\n";
+        ss<<"Socket(s): "<<sockets.size()<<"\n";
+    }
+
+    uint32_t freq;
+
+    if (read_device_u32(SYS_CPU "cpu0/cpufreq/cpuinfo_max_freq", &freq) == 0) {
+        ss<<"CPU max MHz: "<<freq / 1000<<"\n";
+    }
+
+    if (read_device_u32(SYS_CPU "cpu0/cpufreq/cpuinfo_min_freq", &freq) == 0) {
+        ss<<"CPU min MHz: "<<freq / 1000<<"\n";
+    }
+
+    string driver = read_attr(SYS_CPU "cpu0/cpufreq/scaling_driver");
+
+    if (!driver.empty()) {
+        ss<<"Scaling driver: "<<driver<<"\n";
+    }
+
+    for (uint32_t n = 0; ; n++) {
+        string cache = SYS_CPU "cpu0/cache/index" + to_string(n) + "/";
+        string level = read_attr(cache + "level");
+
+        if (level.empty()) {
+            break;
+        }
+
+        string type = read_attr(cache + "type");
+        string suffix = type == "Data" ? "d" : (type == "Instruction" ? "i" : "");
+
+        ss<<"L"<<level<<suffix<<" cache: "<<read_attr(cache + "size")
+          <<" (shared by "<<cpu_list_count(read_attr(cache + "shared_cpu_list"))<<" cpus)\n";
+    }
+
+    vector<string> vulnerabilities;
+    error_code ec;
+
+    for (const auto& entry : filesystem::directory_iterator(SYS_CPU "vulnerabilities", ec)) {
+        vulnerabilities.push_back(entry.path().filename().string());
+    }
+
+    sort(vulnerabilities.begin(), vulnerabilities.end());
+
+    for (string& name : vulnerabilities) {
+        ss<<"Vulnerability "<<name<<": "<<read_attr(SYS_CPU "vulnerabilities/" + name)<<"\n";
+    }
+
+    out.text = ss.str();
+
+    return 0;
+}
+
+/*
+  sd-journal is dlopen'ed so neither headers nor libsystemd are needed to
+  build, these match sd-journal.h
+*/
+#define SD_JOURNAL_LOCAL_ONLY 1
+
+typedef struct sd_journal sd_journal;
+
+struct sd_journal_api_t
+{
+    int (*open)(sd_journal** ret, int flags);
+    void (*close)(sd_journal* j);
+    int (*seek_tail)(sd_journal* j);
+    int (*previous)(sd_journal* j);
+    int (*get_realtime_usec)(sd_journal* j, uint64_t* ret);
+    int (*get_data)(sd_journal* j, const char* field, const void** data, size_t* length);
+};
+
+static bool journal_api(sd_journal_api_t& api)
+{
+    void* lib = dlopen("libsystemd.so.0", RTLD_NOW | RTLD_LOCAL);
+
+    if (!lib) {
+        return false;
+    }
+
+    api.open = (int (*)(sd_journal**, int))dlsym(lib, "sd_journal_open");
+    api.close = (void (*)(sd_journal*))dlsym(lib, "sd_journal_close");
+    api.seek_tail = (int (*)(sd_journal*))dlsym(lib, "sd_journal_seek_tail");
+    api.previous = (int (*)(sd_journal*))dlsym(lib, "sd_journal_previous");
+    api.get_realtime_usec = (int (*)(sd_journal*, uint64_t*))dlsym(lib, "sd_journal_get_realtime_usec");
+    api.get_data = (int (*)(sd_journal*, const char*, const void**, size_t*))dlsym(lib, "sd_journal_get_data");
+
+    /* library stays loaded, it is needed until exit anyway */
+    return api.open and api.close and api.seek_tail and api.previous and api.get_realtime_usec and api.get_data;
+}
+
+/* value of field in current entry, without the FIELD= prefix */
+static string journal_field(sd_journal_api_t& api, sd_journal* j, const char* field)
+{
+    const void* data;
+    size_t length;
+    size_t prefix = strlen(field) + 1;
+
+    if (api.get_data(j, field, &data, &length) < 0 or length < prefix) {
+        return "";
+    }
+
+    return string((const char*)data + prefix, length - prefix);
+}
+
+/*
+  Walks journal once, newest first, and builds both the full and the
+  critical (emerg..crit) listings. Each stops growing at its byte cap, so the
+  most recent entries are the ones kept
+*/
+static int collect_journal(collector_output_t& out)
+{
+    sd_journal_api_t api;
+
+    if (!journal_api(api)) {
+        return COLLECTOR_NOT_APPLICABLE;
+    }
+
+    size_t max_bytes = JOURNAL_MAX_BYTES;
+    char* env = getenv(SLB_REPORT_JOURNAL_MAX);
+
+    if (env) {
+        max_bytes = strtoull(env, nullptr, 10);
+    }
+
+    sd_journal* j;
+    int status = api.open(&j, SD_JOURNAL_LOCAL_ONLY);
+
+    if (status < 0) {
+        return -status;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uint64_t since = (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000 - JOURNAL_SINCE_USEC;
+
+    vector<string> full;
+    vector<string> critical;
+    size_t full_bytes = 0;
+    size_t critical_bytes = 0;
+
+    api.seek_tail(j);
+
+    while ((full_bytes < max_bytes or critical_bytes < max_bytes) and api.previous(j) > 0) {
+        uint64_t usec;
+
+        if (api.get_realtime_usec(j, &usec) < 0) {
+            continue;
+        }
+
+        if (usec < since) {
+            break;
+        }
+
+        uint32_t priority = 6;
+        string value = journal_field(api, j, "PRIORITY");
+
+        parse_u32(value.c_str(), &priority);
+
+        bool is_critical = priority <= JOURNAL_CRITICAL;
+
+        /* nothing left to fill for this entry */
+        if (full_bytes >= max_bytes and !is_critical) {
+            continue;
+        }
+
+        char stamp[32];
+        time_t sec = usec / 1000000;
+        tm local;
+
+        localtime_r(&sec, &local);
+        strftime(stamp, sizeof(stamp), "%b %d %H:%M:%S", &local);
+
+        string ident = journal_field(api, j, "SYSLOG_IDENTIFIER");
+
+        if (ident.empty()) {
+            ident = journal_field(api, j, "_COMM");
+        }
+
+        string pid = journal_field(api, j, "_PID");
+        string line = string(stamp) + " " + journal_field(api, j, "_HOSTNAME") + " " + ident;
+
+        if (!pid.empty()) {
+            line += "[" + pid + "]";
+        }
+
+        line += ": " + journal_field(api, j, "MESSAGE") + "\n";
+
+        if (full_bytes < max_bytes) {
+            full_bytes += line.size();
+            full.push_back(line);
+        }
+
+        if (is_critical and critical_bytes < max_bytes) {
+            critical_bytes += line.size();
+            critical.push_back(line);
+        }
+    }
+
+    api.close(j);
+
+    out.text.reserve(full_bytes);
+
+    for (auto it = full.rbegin(); it != full.rend(); it++) {
+        out.text += *it;
+    }
+
+    string text;
+
+    text.reserve(critical_bytes);
+
+    for (auto it = critical.rbegin(); it != critical.rend(); it++) {
+        text += *it;
+    }
+
+    out.extra.push_back({"journal-critical.txt", std::move(text)});
+
+    return 0;
+}
+
+static const native_collector_t collectors[] = {
+    {"blk", collect_blk},
+    {"cpu", collect_cpu},
+    {"date", collect_date},
+    {"journal", collect_journal},
+    {"mem", collect_mem},
+    {"pci", collect_pci},
+    {"usb", collect_usb},
+    {nullptr, nullptr}
+};
+
+const native_collector_t* native_collectors()
+{
+    return collectors;
+}
+
+/*
+  What cached collectors depend on. A path is stat'ed, a path starting with
+  @ is listed, as sysfs directories keep their mtime when devices come and go.
+  A name starting with $ is an environment variable
+*/
+struct collector_inputs_t
+{
+    const char* name;
+    const char* inputs[8];
+};
+
+static const collector_inputs_t cache_inputs[] = {
+    {"apt", {"/var/lib/dpkg/status", nullptr}},
+    {"apt-upgradeable", {"/var/lib/dpkg/status", "/var/lib/apt/lists", nullptr}},
+    {"dnf", {"/var/lib/rpm", "/var/lib/rpm/rpmdb.sqlite", "/usr/lib/sysimage/rpm/rpmdb.sqlite", nullptr}},
+    {"flatpak", {"/var/lib/flatpak/app", "/var/lib/flatpak/runtime", nullptr}},
+    {"pamac", {"/var/lib/pacman/local", nullptr}},
+    {"dmi", {"/sys/firmware/dmi/tables/DMI", nullptr}},
+    {"pci", {"@/sys/bus/pci/devices", "/usr/share/hwdata/pci.ids", "/usr/share/misc/pci.ids", nullptr}},
+    {"usb", {"@/sys/bus/usb/devices", "/usr/share/hwdata/usb.ids", "/usr/share/misc/usb.ids", "/var/lib/usbutils/usb.ids", nullptr}},
+    {nullptr, {nullptr}}
+};
+
+/* FNV-1a, plenty to tell inputs apart, this is no security boundary */
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    for (size_t n = 0; n < size; n++) {
+        hash ^= bytes[n];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static uint64_t hash_string(uint64_t hash, const string& str)
+{
+    /* length goes too, so "ab"+"c" and "a"+"bc" differ */
+    uint64_t size = str.size();
+
+    hash = hash_bytes(hash, &size, sizeof(size));
+
+    return hash_bytes(hash, str.data(), str.size());
+}
+
+static uint64_t hash_stat(uint64_t hash, const string& path)
+{
+    struct stat st;
+
+    if (stat(path.c_str(), &st) < 0) {
+        return hash_string(hash, "missing");
+    }
+
+    uint64_t fields[] = {(uint64_t)st.st_ino, (uint64_t)st.st_size,
+                         (uint64_t)st.st_mtim.tv_sec, (uint64_t)st.st_mtim.tv_nsec};
+
+    return hash_bytes(hash, fields, sizeof(fields));
+}
+
+bool collector_key(const string& name, const string& program, uint64_t* key)
+{
+    const collector_inputs_t* entry = cache_inputs;
+
+    while (entry->name and name != entry->name) {
+        entry++;
+    }
+
+    if (!entry->name) {
+        return false;
+    }
+
+    uint64_t hash = FNV_OFFSET;
+    uint32_t version = CACHE_VERSION;
+
+    hash = hash_bytes(hash, &version, sizeof(version));
+    hash = hash_string(hash, name);
+    hash = hash_stat(hash, program);
+
+    for (int n = 0; entry->inputs[n]; n++) {
+        const char* input = entry->inputs[n];
+
+        hash = hash_string(hash, input);
+
+        if (input[0] == '$') {
+            char* value = getenv(input + 1);
+            hash = hash_string(hash, value ? value : "");
+        }
+        else if (input[0] == '@') {
+            vector<string> names;
+            error_code ec;
+
+            for (const auto& dir : filesystem::directory_iterator(input + 1, ec)) {
+                names.push_back(dir.path().filename().string());
+            }
+
+            sort(names.begin(), names.end());
+
+            for (const string& dir : names) {
+                hash = hash_string(hash, dir);
+            }
+        }
+        else {
+            hash = hash_stat(hash, input);
+        }
+    }
+
+    *key = hash;
+
+    return true;
+}
+
+/* cache entries are a "key hash size" line followed by output */
+bool collector_cache_get(const string& name, uint64_t key, collector_output_t& out)
+{
+    string data = read_text(SLB_REPORT_CACHE + name);
+    size_t eol = data.find('\n');
+
+    if (eol == string::npos) {
+        return false;
+    }
+
+    unsigned long long stored_key;
+    unsigned long long stored_hash;
+    unsigned long long stored_size;
+
+    if (sscanf(data.c_str(), "%llx %llx %llu", &stored_key, &stored_hash, &stored_size) != 3 or stored_key != key) {
+        return false;
+    }
+
+    string text = data.substr(eol + 1);
+
+    /* a torn or tampered entry is just a miss */
+    if (text.size() != stored_size or hash_string(FNV_OFFSET, text) != stored_hash) {
+        return false;
+    }
+
+    out.text = std::move(text);
+    out.extra.clear();
+
+    return true;
+}
+
+int collector_cache_put(const string& name, uint64_t key, const collector_output_t& out)
+{
+    if (out.extra.size() > 0) {
+        return EINVAL;
+    }
+
+    /* mkdir -p, cache is root only as reports may hold private data */
+    string dir;
+
+    for (const char* part : {"/var/cache/slimbook/", SLB_REPORT_CACHE}) {
+        dir = part;
+
+        if (mkdir(dir.c_str(), 0700) < 0 and errno != EEXIST) {
+            return errno;
+        }
+    }
+
+    char header[64];
+
+    snprintf(header, sizeof(header), "%016llx %016llx %llu\n", (unsigned long long)key,
+             (unsigned long long)hash_string(FNV_OFFSET, out.text), (unsigned long long)out.text.size());
+
+    string path = dir + name;
+    string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+
+    if (fd < 0) {
+        return errno;
+    }
+
+    string data = header + out.text;
+    const char* ptr = data.data();
+    size_t size = data.size();
+    int status = 0;
+
+    while (size > 0) {
+        ssize_t len = write(fd, ptr, size);
+
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            status = errno;
+            break;
+        }
+
+        ptr += len;
+        size -= len;
+    }
+
+    close(fd);
+
+    if (status == 0 and rename(tmp.c_str(), path.c_str()) < 0) {
+        status = errno;
+    }
+
+    if (status != 0) {
+        unlink(tmp.c_str());
+    }
+
+    return status;
+}
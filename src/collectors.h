@@ -0,0 +1,68 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_COLLECTORS_H
+#define SLB_COLLECTORS_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+/* returned by collectors that do not apply to this system, as report.d scripts do */
+#define COLLECTOR_NOT_APPLICABLE 200
+
+typedef struct collector_output_t {
+    /* stored as <name>.txt */
+    std::string text;
+    /* further archive entries as file name and contents, for collectors that split their output */
+    std::vector<std::pair<std::string, std::string>> extra;
+} collector_output_t;
+
+typedef int (*collector_proc)(collector_output_t& out);
+
+typedef struct native_collector_t {
+    const char* name;
+    collector_proc collect;
+} native_collector_t;
+
+/* Environment variable with the byte cap for each journal stream */
+#define SLB_REPORT_JOURNAL_MAX "SLB_REPORT_JOURNAL_MAX"
+
+/* Gets report collectors built into slimbookctl, terminated by a null name.
+   They run on a worker thread, one after another */
+const native_collector_t* native_collectors();
+
+#define SLB_REPORT_CACHE "/var/cache/slimbook/report/"
+
+/*
+  Hashes everything output of collector name depends on, as package
+  database or bus listings, plus program file producing it. Returns false
+  for collectors whose output is not worth caching
+*/
+bool collector_key(const std::string& name, const std::string& program, uint64_t* key);
+
+/* Gets output cached for name if it was stored under key */
+bool collector_cache_get(const std::string& name, uint64_t key, collector_output_t& out);
+
+/* Stores output for name under key, returns 0 or errno */
+int collector_cache_put(const std::string& name, uint64_t key, const collector_output_t& out);
+
+#endif
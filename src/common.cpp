@@ -19,64 +19,1038 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
 #include "common.h"
+#include "trace.h"
+#include "stats.h"
 
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <regex>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <cpuid.h>
 
 using namespace std;
 
-bool find_file(string path, string file, string& out) {
-    out = "";
+static string root_prefix;
+
+/* environment is only read once, root_set overrides it */
+static string& _root()
+{
+    static bool loaded = []() {
+        const char* env = secure_getenv(SLB_ROOT_ENV);
 
-    for (const auto &entryRecDir : filesystem::recursive_directory_iterator(path)) {
-        string entryPath = entryRecDir.path().string();
-        if (entryPath.find(file) != string::npos) {
-            out = entryPath.substr(0, entryPath.size() - file.size());
-            return true;
+        if (env) {
+            root_prefix = env;
         }
+
+        while (!root_prefix.empty() and root_prefix.back() == '/') {
+            root_prefix.pop_back();
+        }
+
+        return true;
+    }();
+
+    (void)loaded;
+
+    return root_prefix;
+}
+
+void root_set(const char* root)
+{
+    string& prefix = _root();
+
+    prefix = root ? root : "";
+
+    while (!prefix.empty() and prefix.back() == '/') {
+        prefix.pop_back();
     }
+}
 
-    return false;
+bool root_active()
+{
+    return !_root().empty();
+}
+
+const char* root_path(const char* path, char* buf, size_t size)
+{
+    const string& prefix = _root();
+
+    if (prefix.empty()) {
+        return path;
+    }
+
+    snprintf(buf, size, "%s%s", prefix.c_str(), path);
+
+    return buf;
+}
+
+string root_path(const string& path)
+{
+    return _root() + path;
 }
 
 void read_device(string path, string &out) {
-    ifstream file;
+    traced_string(TRACE_OP_READ, path.c_str(), out, [&]() {
+        ifstream file;
+
+        file.open(root_path(path).c_str());
+        std::getline(file, out);
+        file.close();
+        stats_syscalls(3);
 
-    file.open(path.c_str());
-    std::getline(file, out);
-    file.close();
+        return 0;
+    });
 }
 
 void write_device(string path, string in) {
-    ofstream file;
-
-    file.open(path.c_str());
-    file << in;
-    file.close();
-}
-
-vector<string> get_modules()
-{
-    vector<string> modules;
-    
-    ifstream file;
-    
-    file.open("/proc/modules");
-    
-    while (file.good()) {
-        string module_name;
-        string tmp;
-        
-        file>>module_name;
-        std::getline(file,tmp);
-        modules.push_back(module_name);
-    }
-    
-    file.close();
-    
-    return modules;
+    traced_call(TRACE_OP_WRITE, path.c_str(), in.data(), in.size(), [&]() {
+        ofstream file;
+
+        file.open(root_path(path).c_str());
+        file << in;
+        file.close();
+        stats_syscalls(3);
+        stats_ec_write();
+
+        return 0;
+    });
+}
+
+int read_device_file(const char* path, string& out)
+{
+    return traced_string(TRACE_OP_READ, path, out, [&]() {
+        ifstream file(root_path(path), ios::binary);
+
+        if (!file.good()) {
+            stats_syscalls(1);
+            return ENOENT;
+        }
+
+        out.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        /* open, close and a read per filebuf chunk plus the one hitting EOF */
+        stats_syscalls(3 + out.size() / BUFSIZ);
+
+        return 0;
+    });
+}
+
+bool device_exists(const char* path)
+{
+    return traced_call(TRACE_OP_STAT, path, nullptr, 0, [&]() {
+        char full[SLB_PATH_MAX];
+        struct stat st;
+
+        stats_syscalls(1);
+
+        return stat(root_path(path, full, sizeof(full)), &st) == 0 ? 0 : errno;
+    }) == 0;
+}
+
+int list_device_dir(const char* path, vector<string>& names)
+{
+    string data;
+
+    names.clear();
+
+    int status = traced_string(TRACE_OP_LIST, path, data, [&]() {
+        error_code ec;
+
+        for (const auto& entry : filesystem::directory_iterator(root_path(path), ec)) {
+            data += entry.path().filename().string();
+            data += '\0';
+        }
+
+        /* open, close and getdents until it comes back empty */
+        stats_syscalls(4);
+
+        return ec.value();
+    });
+
+    for (size_t pos = 0; pos < data.size(); pos = data.find('\0', pos) + 1) {
+        names.push_back(data.c_str() + pos);
+    }
+
+    return status;
+}
+
+int read_device_link(const char* path, string& out)
+{
+    return traced_string(TRACE_OP_LINK, path, out, [&]() {
+        error_code ec;
+
+        out = filesystem::read_symlink(root_path(path), ec).string();
+        stats_syscalls(1);
+
+        return ec.value();
+    });
+}
+
+void device_cpuid(uint32_t level, uint32_t* regs)
+{
+    char key[16];
+    snprintf(key, sizeof(key), "%x", level);
+
+    ssize_t len = traced_read(TRACE_OP_CPUID, key, (char*)regs, 4 * sizeof(uint32_t), [&]() {
+        __cpuid(level, regs[0], regs[1], regs[2], regs[3]);
+
+        return (ssize_t)(4 * sizeof(uint32_t));
+    });
+
+    if (len != 4 * sizeof(uint32_t)) {
+        memset(regs, 0, 4 * sizeof(uint32_t));
+    }
+}
+
+struct shadow_entry_t
+{
+    char value[SLB_DEVICE_BUFFER_SIZE];
+    size_t len;
+    chrono::steady_clock::time_point stamp;
+};
+
+/*
+  last written or read value of each shadowed attribute, keyed by its path
+  literal so that lookups neither build nor allocate a key
+*/
+static map<const char*,shadow_entry_t> shadow;
+static mutex shadow_mutex;
+static chrono::milliseconds shadow_ttl(5000);
+static atomic<uint64_t> shadow_writes(0);
+static atomic<uint64_t> shadow_skipped(0);
+static thread_local bool shadow_force = false;
+
+static void shadow_store(const char* path, const char* buf, size_t len)
+{
+    lock_guard<mutex> lock(shadow_mutex);
+
+    if (len >= SLB_DEVICE_BUFFER_SIZE) {
+        shadow.erase(path);
+        return;
+    }
+
+    shadow_entry_t& entry = shadow[path];
+
+    memcpy(entry.value, buf, len);
+    entry.len = len;
+    entry.stamp = chrono::steady_clock::now();
+}
+
+static bool shadow_match(const char* path, const char* buf, size_t len)
+{
+    lock_guard<mutex> lock(shadow_mutex);
+    auto it = shadow.find(path);
+
+    if (it == shadow.end() or shadow_ttl.count() == 0) {
+        return false;
+    }
+
+    if (chrono::steady_clock::now() - it->second.stamp > shadow_ttl) {
+        shadow.erase(it);
+        return false;
+    }
+
+    return it->second.len == len and memcmp(it->second.value, buf, len) == 0;
+}
+
+void shadow_set_ttl(uint32_t ms)
+{
+    lock_guard<mutex> lock(shadow_mutex);
+
+    shadow_ttl = chrono::milliseconds(ms);
+}
+
+void shadow_set_force(bool force)
+{
+    shadow_force = force;
+}
+
+bool shadow_forced()
+{
+    return shadow_force;
+}
+
+void shadow_invalidate(const char* path)
+{
+    lock_guard<mutex> lock(shadow_mutex);
+
+    if (path) {
+        shadow.erase(path);
+    }
+    else {
+        shadow.clear();
+    }
+}
+
+void shadow_stats(uint64_t* writes, uint64_t* skipped)
+{
+    *writes = shadow_writes;
+    *skipped = shadow_skipped;
+}
+
+int read_device_buf(const char* path, char* buf, size_t size, int flags)
+{
+    if (size == 0) {
+        return EINVAL;
+    }
+
+    ssize_t len = traced_read(TRACE_OP_READ, path, buf, size - 1, [&]() {
+        char full[SLB_PATH_MAX];
+        int fd = open(root_path(path, full, sizeof(full)), O_RDONLY | O_CLOEXEC);
+
+        stats_syscalls(1);
+
+        if (fd < 0) {
+            return (ssize_t)-errno;
+        }
+
+        ssize_t ret;
+
+        do {
+            ret = read(fd, buf, size - 1);
+            stats_syscalls(1);
+        } while (ret < 0 and errno == EINTR);
+
+        if (ret < 0) {
+            ret = -errno;
+        }
+
+        close(fd);
+        stats_syscalls(1);
+
+        return ret;
+    });
+
+    int status = len < 0 ? -len : 0;
+
+    if (status != 0) {
+        buf[0] = 0;
+        return status;
+    }
+
+    buf[len] = 0;
+
+    /* keep first line only, as getline does */
+    char* eol = (char*)memchr(buf, '\n', len);
+
+    if (eol) {
+        *eol = 0;
+    }
+
+    if (flags & DEVICE_SHADOW) {
+        shadow_store(path, buf, strlen(buf));
+    }
+
+    return 0;
+}
+
+int write_device_buf(const char* path, const char* buf, size_t len, int flags)
+{
+    if (flags & DEVICE_SHADOW) {
+        /*
+          reading back on qc71 is an EC transaction too, so a match is
+          trusted until it expires. Firmware changes behind our back are
+          covered by invalidation on resume and platform uevents, and by
+          slb_shadow_force
+        */
+        if (!shadow_force and shadow_match(path, buf, len)) {
+            shadow_skipped++;
+            return 0;
+        }
+
+        shadow_writes++;
+    }
+
+    int status = traced_call(TRACE_OP_WRITE, path, buf, len, [&]() {
+        char full[SLB_PATH_MAX];
+        /* sysfs ignores O_TRUNC, fixture files would keep the tail of a longer value */
+        int fd = open(root_path(path, full, sizeof(full)), O_WRONLY | O_TRUNC | O_CLOEXEC);
+
+        stats_syscalls(1);
+
+        if (fd < 0) {
+            return errno;
+        }
+
+        ssize_t ret;
+
+        do {
+            ret = write(fd, buf, len);
+            stats_syscalls(1);
+        } while (ret < 0 and errno == EINTR);
+
+        stats_ec_write();
+
+        int res = ret < 0 ? errno : 0;
+
+        if (res == 0 and (size_t)ret != len) {
+            res = EIO;
+        }
+
+        close(fd);
+        stats_syscalls(1);
+
+        return res;
+    });
+
+    if (flags & DEVICE_SHADOW) {
+        if (status == 0) {
+            shadow_store(path, buf, len);
+        }
+        else {
+            shadow_invalidate(path);
+        }
+    }
+
+    return status;
+}
+
+int parse_u32(const char* str, uint32_t* out, int base, const char** end)
+{
+    const char* first = str;
+
+    while (*first == ' ' or *first == '\t') {
+        first++;
+    }
+
+    const char* last = first + strlen(first);
+    bool prefixed = first[0] == '0' and (first[1] == 'x' or first[1] == 'X');
+
+    if (base == 0) {
+        if (prefixed) {
+            base = 16;
+        }
+        else {
+            base = (first[0] == '0' and first[1] >= '0' and first[1] <= '7') ? 8 : 10;
+        }
+    }
+
+    if (base == 16 and prefixed) {
+        first += 2;
+    }
+
+    uint32_t value;
+    std::from_chars_result res = std::from_chars(first, last, value, base);
+
+    if (res.ec == std::errc::invalid_argument) {
+        return EINVAL;
+    }
+
+    if (res.ec == std::errc::result_out_of_range) {
+        return ERANGE;
+    }
+
+    *out = value;
+
+    if (end) {
+        *end = res.ptr;
+    }
+
+    return 0;
+}
+
+int parse_u32_list(const char* str, uint32_t* out, int count, int base)
+{
+    for (int n = 0; n < count; n++) {
+        int status = parse_u32(str, &out[n], base, &str);
+
+        if (status != 0) {
+            return status;
+        }
+    }
+
+    return 0;
+}
+
+int format_u32(char* buf, size_t size, uint32_t value, int base, int width)
+{
+    char tmp[32];
+    std::to_chars_result res = std::to_chars(tmp, tmp + sizeof(tmp), value, base);
+    int len = res.ptr - tmp;
+    int pad = width > len ? width - len : 0;
+
+    if ((size_t)(pad + len) >= size) {
+        return -1;
+    }
+
+    memset(buf, '0', pad);
+    memcpy(buf + pad, tmp, len);
+    buf[pad + len] = 0;
+
+    return pad + len;
+}
+
+int read_device_u32(const char* path, uint32_t* out, int base, int flags)
+{
+    char buf[SLB_DEVICE_BUFFER_SIZE];
+    int status = read_device_buf(path, buf, sizeof(buf), flags);
+
+    if (status != 0) {
+        return status;
+    }
+
+    return parse_u32(buf, out, base);
+}
+
+int write_device_u32(const char* path, uint32_t value, int flags)
+{
+    char buf[SLB_DEVICE_BUFFER_SIZE];
+    int len = format_u32(buf, sizeof(buf), value);
+
+    return write_device_buf(path, buf, len, flags);
+}
+
+struct uring_t
+{
+    int fd;
+    uint32_t entries;
+
+    void* sq_ptr;
+    size_t sq_size;
+    void* cq_ptr;
+    size_t cq_size;
+    io_uring_sqe* sqes;
+
+    uint32_t* sq_head;
+    uint32_t* sq_tail;
+    uint32_t* sq_mask;
+    uint32_t* sq_array;
+    uint32_t* cq_head;
+    uint32_t* cq_tail;
+    uint32_t* cq_mask;
+    io_uring_cqe* cqes;
+};
+
+struct device_batch
+{
+    uint32_t capacity;
+    uint32_t count;
+    int* fds;
+    int* status;
+    char* slab;
+    /* system paths, as traces refer to them */
+    char** paths;
+
+    /* io_uring engine, fd is -1 when falling back to pread */
+    uring_t ring;
+    bool files_registered;
+};
+
+static int _uring_setup(uring_t* ring, uint32_t entries)
+{
+    io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return errno;
+    }
+
+    ring->entries = params.sq_entries;
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sq_size = ring->cq_size = std::max(ring->sq_size, ring->cq_size);
+    }
+
+    ring->sq_ptr = mmap(nullptr, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+
+    if (ring->sq_ptr == MAP_FAILED) {
+        int status = errno;
+        close(ring->fd);
+        ring->fd = -1;
+        return status;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    }
+    else {
+        ring->cq_ptr = mmap(nullptr, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    }
+
+    ring->sqes = (io_uring_sqe*)mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ring->cq_ptr == MAP_FAILED or ring->sqes == MAP_FAILED) {
+        int status = errno;
+
+        if (ring->cq_ptr != MAP_FAILED and ring->cq_ptr != ring->sq_ptr) {
+            munmap(ring->cq_ptr, ring->cq_size);
+        }
+
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(ring->fd);
+        ring->fd = -1;
+        return status;
+    }
+
+    char* sq = (char*)ring->sq_ptr;
+    char* cq = (char*)ring->cq_ptr;
+
+    ring->sq_head = (uint32_t*)(sq + params.sq_off.head);
+    ring->sq_tail = (uint32_t*)(sq + params.sq_off.tail);
+    ring->sq_mask = (uint32_t*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (uint32_t*)(sq + params.sq_off.array);
+    ring->cq_head = (uint32_t*)(cq + params.cq_off.head);
+    ring->cq_tail = (uint32_t*)(cq + params.cq_off.tail);
+    ring->cq_mask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    return 0;
+}
+
+static void _uring_free(uring_t* ring)
+{
+    if (ring->fd < 0) {
+        return;
+    }
+
+    munmap(ring->sqes, ring->entries * sizeof(io_uring_sqe));
+
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+    ring->fd = -1;
+}
+
+static void _device_batch_store(device_batch* batch, uint32_t n, int res)
+{
+    char* buf = batch->slab + n * SLB_DEVICE_BUFFER_SIZE;
+
+    if (res < 0) {
+        batch->status[n] = -res;
+        buf[0] = 0;
+        return;
+    }
+
+    batch->status[n] = 0;
+    buf[res] = 0;
+
+    char* eol = (char*)memchr(buf, '\n', res);
+
+    if (eol) {
+        *eol = 0;
+    }
+}
+
+/* Submits a chunk of fixed buffer reads and waits for all of them */
+static int _device_batch_uring_read(device_batch* batch, uint32_t first, uint32_t count)
+{
+    uring_t* ring = &batch->ring;
+    uint32_t tail = *ring->sq_tail;
+
+    for (uint32_t n = 0; n < count; n++) {
+        uint32_t index = tail & *ring->sq_mask;
+        io_uring_sqe* sqe = &ring->sqes[index];
+        uint32_t entry = first + n;
+
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->flags = IOSQE_FIXED_FILE;
+        sqe->fd = entry;
+        sqe->addr = (uint64_t)(uintptr_t)(batch->slab + entry * SLB_DEVICE_BUFFER_SIZE);
+        sqe->len = SLB_DEVICE_BUFFER_SIZE - 1;
+        sqe->off = 0;
+        sqe->buf_index = 0;
+        sqe->user_data = entry;
+
+        ring->sq_array[index] = index;
+        tail++;
+    }
+
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+    int ret;
+    uint32_t submitted = 0;
+
+    /* kernel may take fewer entries than asked, ie: short of memory, and does not wait then */
+    while (submitted < count) {
+        uint32_t wait = submitted == 0 ? count : 0;
+
+        do {
+            ret = syscall(__NR_io_uring_enter, ring->fd, count - submitted, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            stats_syscalls(1);
+        } while (ret < 0 and errno == EINTR);
+
+        if (ret <= 0) {
+            break;
+        }
+
+        submitted += ret;
+    }
+
+    if (submitted < count) {
+        /* take back entries kernel did not consume and read them the slow way */
+        __atomic_store_n(ring->sq_tail, __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+
+        for (uint32_t entry = first + submitted; entry < first + count; entry++) {
+            ssize_t len = pread(batch->fds[entry], batch->slab + entry * SLB_DEVICE_BUFFER_SIZE, SLB_DEVICE_BUFFER_SIZE - 1, 0);
+            stats_syscalls(1);
+
+            _device_batch_store(batch, entry, len < 0 ? -errno : len);
+        }
+    }
+
+    uint32_t head = *ring->cq_head;
+    uint32_t done = 0;
+
+    while (done < submitted) {
+        uint32_t ctail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+        if (head == ctail) {
+            /* submitted entries may still be in flight */
+            do {
+                ret = syscall(__NR_io_uring_enter, ring->fd, 0, submitted - done, IORING_ENTER_GETEVENTS, nullptr, 0);
+                stats_syscalls(1);
+            } while (ret < 0 and errno == EINTR);
+
+            if (ret < 0) {
+                return errno;
+            }
+
+            continue;
+        }
+
+        io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+
+        if (cqe->user_data < batch->count) {
+            _device_batch_store(batch, cqe->user_data, cqe->res);
+        }
+
+        head++;
+        done++;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+device_batch* device_batch_alloc(uint32_t count)
+{
+    device_batch* batch = (device_batch*)calloc(1, sizeof(device_batch));
+
+    if (batch == nullptr) {
+        return nullptr;
+    }
+
+    batch->capacity = count;
+    batch->fds = (int*)calloc(count, sizeof(int));
+    batch->status = (int*)calloc(count, sizeof(int));
+    batch->slab = (char*)calloc(count, SLB_DEVICE_BUFFER_SIZE);
+    batch->paths = (char**)calloc(count, sizeof(char*));
+    batch->ring.fd = -1;
+
+    if (batch->fds == nullptr or batch->status == nullptr or batch->slab == nullptr or batch->paths == nullptr) {
+        device_batch_free(batch);
+        return nullptr;
+    }
+
+    if (count > 0 and _uring_setup(&batch->ring, count) == 0) {
+        iovec iov = {batch->slab, (size_t)count * SLB_DEVICE_BUFFER_SIZE};
+
+        if (syscall(__NR_io_uring_register, batch->ring.fd, IORING_REGISTER_BUFFERS, &iov, 1) < 0) {
+            _uring_free(&batch->ring);
+        }
+    }
+
+    return batch;
+}
+
+int device_batch_add(device_batch* batch, const char* path)
+{
+    if (batch->count >= batch->capacity) {
+        return -1;
+    }
+
+    char full[SLB_PATH_MAX];
+    int fd = -1;
+
+    /* replayed attributes are never opened */
+    if (trace_mode() != TRACE_REPLAY) {
+        fd = open(root_path(path, full, sizeof(full)), O_RDONLY | O_CLOEXEC);
+        stats_syscalls(1);
+
+        if (fd < 0) {
+            return -1;
+        }
+    }
+
+    batch->paths[batch->count] = strdup(path);
+
+    if (batch->files_registered) {
+        syscall(__NR_io_uring_register, batch->ring.fd, IORING_UNREGISTER_FILES, nullptr, 0);
+        batch->files_registered = false;
+    }
+
+    batch->fds[batch->count] = fd;
+
+    return batch->count++;
+}
+
+uint32_t device_batch_count(device_batch* batch)
+{
+    return batch->count;
+}
+
+/* reads every entry through io_uring, or pread when not available */
+static int _device_batch_read(device_batch* batch)
+{
+    if (batch->ring.fd >= 0 and !batch->files_registered and batch->count > 0) {
+        if (syscall(__NR_io_uring_register, batch->ring.fd, IORING_REGISTER_FILES, batch->fds, batch->count) == 0) {
+            batch->files_registered = true;
+        }
+        else {
+            _uring_free(&batch->ring);
+        }
+    }
+
+    if (batch->ring.fd >= 0) {
+        for (uint32_t first = 0; first < batch->count; first += batch->ring.entries) {
+            uint32_t count = std::min(batch->count - first, batch->ring.entries);
+            int status = _device_batch_uring_read(batch, first, count);
+
+            if (status != 0) {
+                return status;
+            }
+        }
+
+        return 0;
+    }
+
+    for (uint32_t n = 0; n < batch->count; n++) {
+        ssize_t len = pread(batch->fds[n], batch->slab + n * SLB_DEVICE_BUFFER_SIZE, SLB_DEVICE_BUFFER_SIZE - 1, 0);
+        stats_syscalls(1);
+
+        _device_batch_store(batch, n, len < 0 ? -errno : len);
+    }
+
+    return 0;
+}
+
+int device_batch_read(device_batch* batch)
+{
+    /* traced reads go one by one, each one gets its own record */
+    if (trace_mode() != TRACE_OFF) {
+        for (uint32_t n = 0; n < batch->count; n++) {
+            char* buf = batch->slab + n * SLB_DEVICE_BUFFER_SIZE;
+            ssize_t len = traced_read(TRACE_OP_READ, batch->paths[n], buf, SLB_DEVICE_BUFFER_SIZE - 1, [&]() {
+                ssize_t ret = pread(batch->fds[n], buf, SLB_DEVICE_BUFFER_SIZE - 1, 0);
+                stats_syscalls(1);
+
+                return ret < 0 ? (ssize_t)-errno : ret;
+            });
+
+            _device_batch_store(batch, n, len);
+        }
+
+        return 0;
+    }
+
+    /* a batch shows as a single timeline span, entries are read at once */
+    uint64_t start = timeline_enabled() ? trace_clock() : 0;
+    int status = _device_batch_read(batch);
+
+    if (start) {
+        char detail[32];
+
+        snprintf(detail, sizeof(detail), "%u files", batch->count);
+        timeline_span(TIMELINE_CAT_SYSFS, "batch_read", detail, start, trace_clock() - start, status);
+    }
+
+    return status;
+}
+
+const char* device_batch_value(device_batch* batch, int index, int* status)
+{
+    if (index < 0 or (uint32_t)index >= batch->count) {
+        if (status) {
+            *status = EINVAL;
+        }
+
+        return nullptr;
+    }
+
+    if (status) {
+        *status = batch->status[index];
+    }
+
+    return batch->status[index] == 0 ? batch->slab + index * SLB_DEVICE_BUFFER_SIZE : nullptr;
+}
+
+int device_batch_uring(device_batch* batch)
+{
+    return batch->ring.fd >= 0;
+}
+
+void device_batch_free(device_batch* batch)
+{
+    if (batch == nullptr) {
+        return;
+    }
+
+    _uring_free(&batch->ring);
+
+    for (uint32_t n = 0; n < batch->count; n++) {
+        if (batch->fds[n] >= 0) {
+            close(batch->fds[n]);
+        }
+
+        free(batch->paths[n]);
+    }
+
+    free(batch->paths);
+    free(batch->fds);
+    free(batch->status);
+    free(batch->slab);
+    free(batch);
+}
+
+struct module_entry_t
+{
+    uint32_t generation;
+    bool loaded;
+};
+
+static map<string,module_entry_t> module_cache;
+static mutex module_mutex;
+static atomic<uint32_t> module_generation(0);
+static atomic<bool> module_listening(false);
+
+bool module_loaded(const char* name)
+{
+    bool listening = module_listening;
+    uint32_t generation = module_generation;
+
+    if (listening) {
+        lock_guard<mutex> lock(module_mutex);
+        auto it = module_cache.find(name);
+
+        if (it != module_cache.end() and it->second.generation == generation) {
+            return it->second.loaded;
+        }
+    }
+
+    char path[256];
+
+    snprintf(path, sizeof(path), "/sys/module/%s", name);
+    bool loaded = device_exists(path);
+
+    if (listening) {
+        lock_guard<mutex> lock(module_mutex);
+
+        module_cache[name] = {generation, loaded};
+    }
+
+    return loaded;
+}
+
+void module_cache_invalidate()
+{
+    module_generation++;
+}
+
+uint32_t module_cache_generation()
+{
+    return module_generation;
+}
+
+static void _module_listener(int fd)
+{
+    char buf[4096];
+
+    while (true) {
+        ssize_t len = recv(fd, buf, sizeof(buf) - 1, 0);
+
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            /* uevents were lost (ENOBUFS) or socket is gone, play safe */
+            module_cache_invalidate();
+            shadow_invalidate(nullptr);
+
+            if (errno != ENOBUFS) {
+                break;
+            }
+
+            continue;
+        }
+
+        buf[len] = 0;
+
+        /* header is action@devpath, ie: add@/module/qc71_laptop */
+        const char* at = strchr(buf, '@');
+
+        /* hwmon devices show up once the module probes, after its own uevent */
+        if (at and (strncmp(at + 1, "/module/", 8) == 0 or strstr(at + 1, "/hwmon/hwmon"))) {
+            module_cache_invalidate();
+        }
+
+        /* a reloaded driver or firmware events on platform devices may change shadowed attributes */
+        if (at and (strncmp(at + 1, "/module/", 8) == 0 or strncmp(at + 1, "/devices/platform/", 18) == 0)) {
+            shadow_invalidate(nullptr);
+        }
+    }
+
+    module_listening = false;
+    close(fd);
+}
+
+int module_listener_start()
+{
+    lock_guard<mutex> lock(module_mutex);
+
+    if (module_listening) {
+        return 0;
+    }
+
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+
+    if (fd < 0) {
+        return errno;
+    }
+
+    sockaddr_nl addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;
+
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        int status = errno;
+        close(fd);
+        return status;
+    }
+
+    module_cache.clear();
+    module_listening = true;
+    thread(_module_listener, fd).detach();
+
+    return 0;
 }
 
 uint16_t swap16(uint16_t data){
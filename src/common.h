@@ -24,13 +24,31 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 #define ALIGN(data, alignto) ((data) & ~((alignto)-1))
 
-#define cpuid(level, regs) do{ __cpuid((level), (regs)[0],(regs)[1],(regs)[2],(regs)[3]); }while(0)
+#define cpuid(level, regs) device_cpuid((level), (regs))
 
-/* Tries to find file recursively in path */
-bool find_file(std::string path, std::string file, std::string& out);
+/* Environment variable naming a directory every system path is resolved
+   under, as a fixture tree. Ignored by setuid and setgid callers */
+#define SLB_ROOT_ENV "SLB_ROOT"
+
+/* Size of buffers holding root prefixed paths */
+#define SLB_PATH_MAX 512
+
+/* Sets root prefix, nullptr or empty for the real system. Not thread safe */
+void root_set(const char* root);
+
+/* Whether system paths are being resolved under a root prefix */
+bool root_active();
+
+/* Resolves an absolute system path under root prefix into buf. Returns path
+   itself, with no copy, when there is no prefix */
+const char* root_path(const char* path, char* buf, size_t size);
+
+/* Same as above, for callers already holding strings */
+std::string root_path(const std::string& path);
 
 /* Reads from the device's file */
 void read_device(std::string path, std::string& out);
@@ -38,8 +56,90 @@ void read_device(std::string path, std::string& out);
 /* Writes to the device's file */
 void write_device(std::string in, std::string out);
 
-/* Retrieves all modules loaded */
-std::vector<std::string> get_modules(void);
+/* Reads a whole file, as binary tables. Returns 0 or errno */
+int read_device_file(const char* path, std::string& out);
+
+/* Checks whether a system path exists */
+bool device_exists(const char* path);
+
+/* Gets names of entries in a system directory. Returns 0 or errno */
+int list_device_dir(const char* path, std::vector<std::string>& names);
+
+/* Reads a symbolic link target. Returns 0 or errno */
+int read_device_link(const char* path, std::string& out);
+
+/* Runs cpuid leaf level into eax, ebx, ecx and edx */
+void device_cpuid(uint32_t level, uint32_t* regs);
+
+/* Size of stack buffers used for sysfs attribute values */
+#define SLB_DEVICE_BUFFER_SIZE 64
+
+/* Device I/O flags */
+#define DEVICE_SHADOW 0x01 /* keep a shadow copy, and skip writes matching it. Path must be a string literal */
+
+/* Reads first line of the device's file into buf, returns 0 or errno */
+int read_device_buf(const char* path, char* buf, size_t size, int flags = 0);
+
+/* Writes len bytes of buf to the device's file, returns 0 or errno */
+int write_device_buf(const char* path, const char* buf, size_t len, int flags = 0);
+
+/* Parses an unsigned integer, base 0 guesses it from prefix as strtoul does.
+   Leading blanks and trailing garbage are accepted. Returns 0, EINVAL or ERANGE */
+int parse_u32(const char* str, uint32_t* out, int base = 10, const char** end = nullptr);
+
+/* Parses count blank separated unsigned integers, as in "r g b" attributes. Returns 0 or errno */
+int parse_u32_list(const char* str, uint32_t* out, int count, int base = 10);
+
+/* Formats value zero padded to width into buf, returns length or -1 */
+int format_u32(char* buf, size_t size, uint32_t value, int base = 10, int width = 0);
+
+/* Reads an unsigned integer from the device's file, returns 0 or errno */
+int read_device_u32(const char* path, uint32_t* out, int base = 10, int flags = 0);
+
+/* Writes an unsigned integer in decimal to the device's file, returns 0 or errno */
+int write_device_u32(const char* path, uint32_t value, int flags = 0);
+
+/* Shadow copy tuning and counters, see slb_shadow_* */
+void shadow_set_ttl(uint32_t ms);
+void shadow_set_force(bool force);
+bool shadow_forced();
+void shadow_invalidate(const char* path);
+void shadow_stats(uint64_t* writes, uint64_t* skipped);
+
+typedef struct device_batch device_batch;
+
+/* Allocates a batch reader for up to count attributes, io_uring is used when kernel allows it */
+device_batch* device_batch_alloc(uint32_t count);
+
+/* Opens and adds an attribute to the batch. Returns its index or -1 */
+int device_batch_add(device_batch* batch, const char* path);
+
+/* Gets number of attributes added to batch */
+uint32_t device_batch_count(device_batch* batch);
+
+/* Reads every attribute from offset 0, in a single submission when io_uring is available. Returns 0 or errno */
+int device_batch_read(device_batch* batch);
+
+/* Gets first line read for index by last device_batch_read, or nullptr on error */
+const char* device_batch_value(device_batch* batch, int index, int* status = nullptr);
+
+/* Whether batch is served by io_uring (1) or sequential pread (0) */
+int device_batch_uring(device_batch* batch);
+
+/* Frees batch and closes its files */
+void device_batch_free(device_batch* batch);
+
+/* Checks if a kernel module is loaded, from /sys/module. Cached while a uevent listener is running */
+bool module_loaded(const char* name);
+
+/* Starts a uevent listener thread that invalidates module_loaded cache. Returns 0 or errno */
+int module_listener_start();
+
+/* Drops cached module_loaded answers */
+void module_cache_invalidate();
+
+/* Bumped on every module or hwmon device uevent, only moves while a listener is running */
+uint32_t module_cache_generation();
 
 /* Swaps 16 bit data for endianness */
 uint16_t swap16(uint16_t data);
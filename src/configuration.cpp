@@ -19,18 +19,39 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
 #include "configuration.h"
+#include "common.h"
 
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <filesystem>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define DB_PATH "/var/lib/slimbook/"
-#define DB_FILE DB_PATH"settings.db"
+#define DB_TEXT_FILE DB_PATH"settings.db"
+#define DB_FILE DB_PATH"settings.bin"
+/* mkostemp template, each store gets its own temp file */
+#define DB_TEMP_FILE DB_PATH"settings.bin.XXXXXX"
 
 using namespace std;
 
-Configuration::Configuration()
+static string to_hex(uint32_t value)
+{
+    char buf[16];
+    
+    format_u32(buf, sizeof(buf), value, 16, 8);
+    
+    return buf;
+}
+
+Configuration::Configuration() : m_map(nullptr), m_map_size(0), m_dirty(false)
 {
 
 }
@@ -38,15 +59,24 @@ Configuration::Configuration()
 
 Configuration::~Configuration()
 {
+    unmap();
+}
 
+void Configuration::unmap()
+{
+    if (m_map) {
+        munmap((void*)m_map, m_map_size);
+        m_map = nullptr;
+        m_map_size = 0;
+    }
 }
 
-void Configuration::load()
+void Configuration::load_text(const char* path)
 {
     ifstream db;
     char buffer[256];
     
-    db.open(DB_FILE);
+    db.open(path);
     
     if (db.good()) {
     
@@ -58,7 +88,16 @@ void Configuration::load()
             if (sep != std::string::npos) {
                 string key = tmp.substr(0,sep);
                 string value = tmp.substr(sep+1,tmp.size());
-                m_data[key] = value;
+                uint32_t u32;
+                const char* end;
+                
+                /* set_u32 always wrote 8 hex digits */
+                if (value.size() == 8 and parse_u32(value.c_str(),&u32,16,&end) == 0 and *end == 0) {
+                    set_u32(key, u32);
+                }
+                else {
+                    set(key, value);
+                }
             }
         }
         
@@ -66,74 +105,445 @@ void Configuration::load()
     }
 }
 
-void Configuration::store()
+void Configuration::load()
 {
-    std::filesystem::create_directory(DB_PATH);
+    unmap();
+    m_data.clear();
+    m_dirty = false;
+    
+    int fd = open(root_path(DB_FILE).c_str(), O_RDONLY | O_CLOEXEC);
     
-    ofstream db;
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            /* one time migration, next store writes the binary db */
+            load_text(root_path(DB_TEXT_FILE).c_str());
+        }
+        
+        return;
+    }
     
-    db.open(DB_FILE);
+    struct stat st;
     
-    if (db.good()) {
-        for (auto p : m_data) {
-            db<<p.first<<":"<<p.second<<endl;
+    if (fstat(fd, &st) == 0 and (size_t)st.st_size >= sizeof(config_header_t)) {
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        
+        if (map != MAP_FAILED) {
+            const config_header_t* header = (const config_header_t*)map;
+            size_t entries_size = (size_t)header->count * sizeof(config_entry_t);
+            
+            if (header->magic == CONFIG_MAGIC and header->version == CONFIG_VERSION and
+                header->size == (size_t)st.st_size and
+                sizeof(config_header_t) + entries_size <= header->pool_offset and
+                header->pool_offset <= header->size) {
+                m_map = (const uint8_t*)map;
+                m_map_size = st.st_size;
+            }
+            else {
+                munmap(map, st.st_size);
+            }
         }
-        db.close();
     }
+    
+    close(fd);
+}
+
+const config_entry_t* Configuration::lookup(const string& key) const
+{
+    if (m_map == nullptr) {
+        return nullptr;
+    }
+    
+    const config_header_t* header = (const config_header_t*)m_map;
+    const config_entry_t* entries = (const config_entry_t*)(m_map + sizeof(config_header_t));
+    size_t first = 0;
+    size_t last = header->count;
+    
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        const config_entry_t* entry = &entries[mid];
+        
+        if ((size_t)entry->key_offset + entry->key_length > m_map_size) {
+            return nullptr;
+        }
+        
+        int cmp = key.compare(0, string::npos, (const char*)m_map + entry->key_offset, entry->key_length);
+        
+        if (cmp == 0) {
+            if (entry->type == CONFIG_TYPE_STRING and (size_t)entry->value + entry->value_length > m_map_size) {
+                return nullptr;
+            }
+            
+            return entry;
+        }
+        
+        if (cmp < 0) {
+            last = mid;
+        }
+        else {
+            first = mid + 1;
+        }
+    }
+    
+    return nullptr;
+}
+
+bool Configuration::find_value(const string& key, config_value_t& out) const
+{
+    std::map<string,config_value_t>::const_iterator it = m_data.find(key);
+    
+    if (it != m_data.end()) {
+        out = it->second;
+        return it->second.type != CONFIG_TYPE_ERASED;
+    }
+    
+    const config_entry_t* entry = lookup(key);
+    
+    if (entry == nullptr) {
+        return false;
+    }
+    
+    out.type = entry->type;
+    out.u32 = 0;
+    out.str.clear();
+    
+    if (entry->type == CONFIG_TYPE_U32) {
+        out.u32 = entry->value;
+    }
+    else {
+        out.str.assign((const char*)m_map + entry->value, entry->value_length);
+    }
+    
+    return true;
+}
+
+static int write_all(int fd, const string& data)
+{
+    size_t done = 0;
+    
+    while (done < data.size()) {
+        ssize_t ret = write(fd, data.c_str() + done, data.size() - done);
+        
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        
+        done += ret;
+    }
+    
+    return 0;
+}
+
+int Configuration::store()
+{
+    if (!m_dirty) {
+        return 0;
+    }
+    
+    std::error_code ec;
+    std::filesystem::create_directory(root_path(DB_PATH), ec);
+    
+    /* merge mapped values with pending ones, std::map keeps them sorted */
+    std::map<string,config_value_t> values;
+    
+    if (m_map) {
+        const config_header_t* header = (const config_header_t*)m_map;
+        const config_entry_t* entries = (const config_entry_t*)(m_map + sizeof(config_header_t));
+        
+        for (uint32_t n = 0; n < header->count; n++) {
+            if ((size_t)entries[n].key_offset + entries[n].key_length > m_map_size) {
+                continue;
+            }
+            
+            string key((const char*)m_map + entries[n].key_offset, entries[n].key_length);
+            config_value_t value;
+            
+            if (find_value(key, value)) {
+                values[key] = value;
+            }
+        }
+    }
+    
+    for (auto& p : m_data) {
+        if (p.second.type == CONFIG_TYPE_ERASED) {
+            values.erase(p.first);
+        }
+        else {
+            values[p.first] = p.second;
+        }
+    }
+    
+    config_header_t header;
+    vector<config_entry_t> entries;
+    string pool;
+    
+    memset(&header, 0, sizeof(header));
+    header.magic = CONFIG_MAGIC;
+    header.version = CONFIG_VERSION;
+    header.count = values.size();
+    header.pool_offset = sizeof(config_header_t) + values.size() * sizeof(config_entry_t);
+    
+    for (auto& p : values) {
+        config_entry_t entry;
+        
+        memset(&entry, 0, sizeof(entry));
+        entry.key_offset = header.pool_offset + pool.size();
+        entry.key_length = p.first.size();
+        entry.type = p.second.type;
+        pool += p.first;
+        
+        if (p.second.type == CONFIG_TYPE_U32) {
+            entry.value = p.second.u32;
+        }
+        else {
+            entry.value = header.pool_offset + pool.size();
+            entry.value_length = p.second.str.size();
+            pool += p.second.str;
+        }
+        
+        entries.push_back(entry);
+    }
+    
+    header.size = header.pool_offset + pool.size();
+    
+    string data;
+    
+    data.append((const char*)&header, sizeof(header));
+    data.append((const char*)entries.data(), entries.size() * sizeof(config_entry_t));
+    data += pool;
+    
+    string temp_file = root_path(DB_TEMP_FILE);
+    string file = root_path(DB_FILE);
+    
+    /*
+      write aside and rename over, so a crash never leaves a half written db.
+      Concurrent stores, ie: slimbookd and slimbookctl, never share a temp file,
+      last rename wins with a whole db
+    */
+    int fd = mkostemp(&temp_file[0], O_CLOEXEC);
+    
+    if (fd < 0) {
+        return errno;
+    }
+    
+    int status = write_all(fd, data);
+    
+    /* mkostemp makes it owner only */
+    if (status == 0 and fchmod(fd, 0644) < 0) {
+        status = errno;
+    }
+    
+    if (status == 0 and fsync(fd) < 0) {
+        status = errno;
+    }
+    
+    close(fd);
+    
+    if (status == 0 and rename(temp_file.c_str(), file.c_str()) < 0) {
+        status = errno;
+    }
+    
+    if (status != 0) {
+        unlink(temp_file.c_str());
+        return status;
+    }
+    
+    /* make the rename itself durable */
+    int dfd = open(root_path(DB_PATH).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    
+    if (dfd >= 0) {
+        fsync(dfd);
+        close(dfd);
+    }
+    
+    m_dirty = false;
+    
+    return 0;
 }
 
 string Configuration::get(string key)
 {
-    return m_data[key];
+    string value;
+    
+    find(key, value);
+    
+    return value;
 }
 
 uint32_t Configuration::get_u32(string key)
 {
-    uint32_t value = std::stoi(m_data[key],0,16);
+    uint32_t value = 0;
+    
+    find_u32(key, value);
     
     return value;
 }
 
 bool Configuration::find(std::string key, std::string& out)
 {
-    std::map<string,string>::iterator it;
-
-    it = m_data.find(key);
-
-    if (it != m_data.end()) {
-        out = it->second;
-        return true;
-    }
-    else {
+    config_value_t value;
+    
+    if (!find_value(key, value)) {
         return false;
     }
+    
+    out = value.type == CONFIG_TYPE_U32 ? to_hex(value.u32) : value.str;
+    
+    return true;
 }
 
 bool Configuration::find_u32(std::string key, uint32_t& out)
 {
-    std::map<string,string>::iterator it;
-
-    it = m_data.find(key);
-
-    if (it != m_data.end()) {
-        out = std::stoi(it->second,0,16);
-        return true;
-    }
-    else {
+    config_value_t value;
+    
+    if (!find_value(key, value)) {
         return false;
     }
+    
+    if (value.type == CONFIG_TYPE_U32) {
+        out = value.u32;
+        return true;
+    }
+    
+    return parse_u32(value.str.c_str(), &out, 16) == 0;
 }
 
 void Configuration::set(string key, string value)
 {
-    m_data[key] = value;
+    config_value_t current;
+    
+    if (find_value(key, current) and current.type == CONFIG_TYPE_STRING and current.str == value) {
+        return;
+    }
+    
+    m_data[key] = {CONFIG_TYPE_STRING, 0, value};
+    m_dirty = true;
 }
 
 void Configuration::set_u32(string key, uint32_t value)
 {
-    stringstream ss;
+    config_value_t current;
     
-    ss<<std::hex<<std::setfill('0')<<std::setw(8)<<value;
-    m_data[key] = ss.str();
+    if (find_value(key, current) and current.type == CONFIG_TYPE_U32 and current.u32 == value) {
+        return;
+    }
+    
+    m_data[key] = {CONFIG_TYPE_U32, value, ""};
+    m_dirty = true;
+}
+
+void Configuration::erase_prefix(const string& prefix)
+{
+    /* mapped keys can not go away until next store, hide them meanwhile */
+    for (auto& p : data()) {
+        if (p.first.compare(0, prefix.size(), prefix) == 0) {
+            m_data[p.first] = {CONFIG_TYPE_ERASED, 0, ""};
+            m_dirty = true;
+        }
+    }
+}
+
+struct profile_field_t
+{
+    uint32_t field;
+    const char* key;
+    uint32_t slb_profile_t::*value;
+};
+
+static const profile_field_t profile_fields[] = {
+    {SLB_PROFILE_BACKLIGHT, "backlight", &slb_profile_t::backlight},
+    {SLB_PROFILE_BRIGHTNESS, "brightness", &slb_profile_t::brightness},
+    {SLB_PROFILE_QC71_PROFILE, "qc71.profile", &slb_profile_t::qc71_profile},
+    {SLB_PROFILE_SILENT_MODE, "qc71.silent", &slb_profile_t::silent_mode},
+    {SLB_PROFILE_TURBO_MODE, "qc71.turbo", &slb_profile_t::turbo_mode},
+    {SLB_PROFILE_CUSTOM_TDP, "qc71.tdp.pl1", &slb_profile_t::tdp_pl1},
+    {SLB_PROFILE_CUSTOM_TDP, "qc71.tdp.pl2", &slb_profile_t::tdp_pl2},
+    {SLB_PROFILE_CUSTOM_TDP, "qc71.tdp.pl4", &slb_profile_t::tdp_pl4},
+    {SLB_PROFILE_FN_LOCK, "qc71.fn_lock", &slb_profile_t::fn_lock},
+    {SLB_PROFILE_SUPER_LOCK, "qc71.super_lock", &slb_profile_t::super_lock},
+    {SLB_PROFILE_MANUAL_CONTROL, "qc71.manual_control", &slb_profile_t::manual_control},
+    {0, nullptr, nullptr}
+};
+
+bool Configuration::find_profile(std::string name, slb_profile_t& out)
+{
+    string prefix = "profile." + name + ".";
+    uint32_t missing = 0;
+    
+    memset(&out, 0, sizeof(out));
+    
+    for (const profile_field_t* f = profile_fields; f->key; f++) {
+        if (find_u32(prefix + f->key, out.*(f->value))) {
+            out.fields |= f->field;
+        }
+        else {
+            missing |= f->field;
+        }
+    }
+    
+    /* custom tdp is only meaningful as a whole */
+    out.fields &= ~(missing & SLB_PROFILE_CUSTOM_TDP);
+    
+    return out.fields != 0;
+}
+
+void Configuration::set_profile(std::string name, const slb_profile_t& profile)
+{
+    string prefix = "profile." + name + ".";
+    
+    /* a field left out now must not come back from a previous save */
+    erase_prefix(prefix);
+    
+    for (const profile_field_t* f = profile_fields; f->key; f++) {
+        if (profile.fields & f->field) {
+            set_u32(prefix + f->key, profile.*(f->value));
+        }
+    }
+}
+
+std::map<string,string> Configuration::data() const
+{
+    std::map<string,string> out;
+    
+    if (m_map) {
+        const config_header_t* header = (const config_header_t*)m_map;
+        const config_entry_t* entries = (const config_entry_t*)(m_map + sizeof(config_header_t));
+        
+        for (uint32_t n = 0; n < header->count; n++) {
+            if ((size_t)entries[n].key_offset + entries[n].key_length > m_map_size) {
+                continue;
+            }
+            
+            string key((const char*)m_map + entries[n].key_offset, entries[n].key_length);
+            config_value_t value;
+            
+            if (find_value(key, value)) {
+                out[key] = value.type == CONFIG_TYPE_U32 ? to_hex(value.u32) : value.str;
+            }
+        }
+    }
+    
+    for (auto& p : m_data) {
+        if (p.second.type == CONFIG_TYPE_ERASED) {
+            out.erase(p.first);
+        }
+        else {
+            out[p.first] = p.second.type == CONFIG_TYPE_U32 ? to_hex(p.second.u32) : p.second.str;
+        }
+    }
+    
+    return out;
 }
 
+string Configuration::text() const
+{
+    string out;
+    
+    for (auto& p : data()) {
+        out += p.first + ":" + p.second + "\n";
+    }
+    
+    return out;
+}
@@ -18,24 +18,93 @@ along with this program; if not, write to the Free Software Foundation,
 Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
+#ifndef SLB_CONFIGURATION_H
+#define SLB_CONFIGURATION_H
+
 #include <string>
 #include <map>
 #include <fstream>
 #include <cstdint>
+#include <cstddef>
+
+#include "slimbook.h"
+
+#define CONFIG_TYPE_STRING 0x01
+#define CONFIG_TYPE_U32    0x02
+/* only in memory, a key erased since load */
+#define CONFIG_TYPE_ERASED 0x00
+
+/*
+ settings.bin layout, native endianness:
+ header, entries sorted by key, then a pool with keys and string values
+*/
+#define CONFIG_MAGIC   0x44424c53 /* SLBD */
+#define CONFIG_VERSION 1
+
+struct config_header_t
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t pool_offset;
+    uint32_t size;
+};
+
+struct config_entry_t
+{
+    uint32_t key_offset;
+    uint16_t key_length;
+    uint8_t type;
+    uint8_t reserved;
+    /* u32 value itself, or pool offset of a string */
+    uint32_t value;
+    uint32_t value_length;
+};
+
+struct config_value_t
+{
+    uint8_t type;
+    uint32_t u32;
+    std::string str;
+};
 
 class Configuration
 {
     protected:
     
-    std::map<std::string,std::string> m_data;
+    /* settings.bin mapped in memory, looked up in place */
+    const uint8_t* m_map;
+    size_t m_map_size;
+    
+    /* values set since load, they override mapped ones */
+    std::map<std::string,config_value_t> m_data;
+    
+    /* true when m_data differs from what is on disk */
+    bool m_dirty;
+    
+    const config_entry_t* lookup(const std::string& key) const;
+    bool find_value(const std::string& key, config_value_t& out) const;
+    void unmap();
+    void load_text(const char* path);
     
     public:
     
     Configuration();
+    Configuration(const Configuration&) = delete;
+    Configuration& operator=(const Configuration&) = delete;
     virtual ~Configuration();
     
+    /* Maps settings.bin, or migrates legacy text settings.db when there is no binary one yet */
     void load();
-    void store();
+    
+    /* Writes settings to disk only if something changed. Returns 0 or errno */
+    int store();
+    
+    bool dirty() const
+    {
+        return m_dirty;
+    }
     
     std::string get(std::string key);
     uint32_t get_u32(std::string key);
@@ -45,9 +114,21 @@ class Configuration
     void set(std::string key, std::string value);
     
     void set_u32(std::string key, uint32_t value);
+    
+    /* Removes every key starting with prefix */
+    void erase_prefix(const std::string& prefix);
 
-    std::map<std::string,std::string> data() const
-    {
-        return m_data;
-    }
+    /* Gets named profile, stored as profile.NAME.FIELD keys */
+    bool find_profile(std::string name, slb_profile_t& out);
+    
+    /* Replaces named profile, fields not set in profile are removed */
+    void set_profile(std::string name, const slb_profile_t& profile);
+    
+    /* Gets all settings as text, u32 values as 8 digit hex */
+    std::map<std::string,std::string> data() const;
+    
+    /* Gets all settings in legacy key:value text format, for debugging */
+    std::string text() const;
 };
+
+#endif
@@ -0,0 +1,199 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "daemon.h"
+#include "common.h"
+#include "trace.h"
+#include "stats.h"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <chrono>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+int daemon_connect()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        return -errno;
+    }
+
+    /* a stuck daemon must not hang callers, ie: sleep hook. Also bounds connect on a full backlog */
+    timeval timeout;
+
+    timeout.tv_sec = DAEMON_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (DAEMON_TIMEOUT_MS % 1000) * 1000;
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SLB_DAEMON_SOCKET, sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        int status = errno;
+        close(fd);
+        return -status;
+    }
+
+    return fd;
+}
+
+int daemon_send(int fd, const void* buf, size_t len)
+{
+    const char* data = (const char*)buf;
+
+    while (len > 0) {
+        ssize_t ret = send(fd, data, len, MSG_NOSIGNAL);
+        stats_syscalls(1);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        data += ret;
+        len -= ret;
+    }
+
+    return 0;
+}
+
+int daemon_recv(int fd, void* buf, size_t len)
+{
+    char* data = (char*)buf;
+
+    while (len > 0) {
+        ssize_t ret = recv(fd, data, len, 0);
+        stats_syscalls(1);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        if (ret == 0) {
+            return EPIPE;
+        }
+
+        data += ret;
+        len -= ret;
+    }
+
+    return 0;
+}
+
+int daemon_call(int fd, const daemon_request_t* request, daemon_response_t* response)
+{
+    int status = daemon_send(fd, request, sizeof(*request));
+
+    if (status != 0) {
+        return status;
+    }
+
+    return daemon_recv(fd, response, sizeof(*response));
+}
+
+/* connection used by library calls, -1 if not connected */
+static int client_fd = -1;
+static std::chrono::steady_clock::time_point client_retry;
+static std::mutex client_mutex;
+
+bool daemon_client_call(uint32_t op, uint32_t attr, uint32_t model, uint32_t* values, int* status)
+{
+    /* a fixture tree or a trace is read directly, daemon serves the real system */
+    if (geteuid() == 0 or root_active() or trace_mode() != TRACE_OFF) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(client_mutex);
+
+    if (client_fd < 0 and std::chrono::steady_clock::now() < client_retry) {
+        return false;
+    }
+
+    daemon_request_t request;
+    daemon_response_t response;
+
+    memset(&request, 0, sizeof(request));
+    request.op = op;
+    request.attr = attr;
+    request.model = model;
+
+    if (op == DAEMON_OP_SET) {
+        memcpy(request.values, values, sizeof(request.values));
+
+        /* force is per thread, so it has to travel with the request */
+        if (shadow_forced()) {
+            request.flags |= DAEMON_FLAG_FORCE;
+        }
+    }
+
+    /* second try covers a daemon restart since last call */
+    for (int retry = 0; retry < 2; retry++) {
+        if (client_fd < 0) {
+            client_fd = daemon_connect();
+
+            if (client_fd < 0) {
+                /* no daemon around, do not try again on every call */
+                client_retry = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                return false;
+            }
+        }
+
+        int ret = daemon_call(client_fd, &request, &response);
+
+        if (ret == 0) {
+            if (op == DAEMON_OP_GET) {
+                memcpy(values, response.values, sizeof(response.values));
+            }
+
+            *status = response.status;
+
+            return true;
+        }
+
+        close(client_fd);
+        client_fd = -1;
+
+        /* daemon is up but not answering, go to hardware and leave it alone for a while */
+        if (ret == EAGAIN or ret == EWOULDBLOCK) {
+            client_retry = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            return false;
+        }
+    }
+
+    return false;
+}
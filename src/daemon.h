@@ -0,0 +1,102 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_DAEMON_H
+#define SLB_DAEMON_H
+
+#include <cstdint>
+#include <cstddef>
+
+#define SLB_DAEMON_SOCKET "/run/slimbook/slimbookd.sock"
+
+#define DAEMON_OP_PING      0x01
+#define DAEMON_OP_SUSPEND   0x02
+#define DAEMON_OP_RESUME    0x03
+#define DAEMON_OP_GET       0x04
+#define DAEMON_OP_SET       0x05
+#define DAEMON_OP_SUBSCRIBE 0x06
+/* pushed to subscribers, never requested */
+#define DAEMON_OP_NOTIFY    0x07
+
+#define DAEMON_ATTR_KBD_BACKLIGHT       0x01
+#define DAEMON_ATTR_KBD_BRIGHTNESS      0x02
+#define DAEMON_ATTR_KBD_BRIGHTNESS_MAX  0x03
+#define DAEMON_ATTR_QC71_MANUAL_CONTROL 0x04
+#define DAEMON_ATTR_QC71_FN_LOCK        0x05
+#define DAEMON_ATTR_QC71_SUPER_LOCK     0x06
+#define DAEMON_ATTR_QC71_SILENT_MODE    0x07
+#define DAEMON_ATTR_QC71_TURBO_MODE     0x08
+#define DAEMON_ATTR_QC71_PROFILE        0x09
+#define DAEMON_ATTR_QC71_CUSTOM_TDP     0x0a
+#define DAEMON_ATTR_QC71_PRIMARY_FAN    0x0b
+#define DAEMON_ATTR_QC71_SECONDARY_FAN  0x0c
+#define DAEMON_ATTR_CLEVO_PRIMARY_FAN   0x0d
+#define DAEMON_ATTR_CLEVO_SECONDARY_FAN 0x0e
+#define DAEMON_ATTR_BATTERY             0x0f
+#define DAEMON_ATTR_AC_STATE            0x10
+#define DAEMON_ATTR_TDP_INFO            0x11
+#define DAEMON_ATTR_MAX                 0x12
+
+#define DAEMON_VALUES 4
+
+/* set is written even if shadow says attribute already holds that value, see slb_shadow_force */
+#define DAEMON_FLAG_FORCE 0x01
+
+/* longest a client waits on slimbookd for connecting, sending or receiving */
+#define DAEMON_TIMEOUT_MS 3000
+
+struct daemon_request_t
+{
+    uint32_t op;
+    /* DAEMON_ATTR_* for get and set */
+    uint32_t attr;
+    /* ignored, slimbookd always uses the model it detected */
+    uint32_t model;
+    /* DAEMON_FLAG_* */
+    uint32_t flags;
+    uint32_t values[DAEMON_VALUES];
+};
+
+struct daemon_response_t
+{
+    /* 0 or errno */
+    int32_t status;
+    uint32_t op;
+    uint32_t attr;
+    uint32_t values[DAEMON_VALUES];
+};
+
+/* Connects to slimbookd, socket times out after DAEMON_TIMEOUT_MS. Returns socket fd or -errno */
+int daemon_connect();
+
+/* Sends a request and waits for its response. Returns 0 or errno, EAGAIN on timeout */
+int daemon_call(int fd, const daemon_request_t* request, daemon_response_t* response);
+
+/* Reads exactly len bytes. Returns 0, errno, or EPIPE on disconnection */
+int daemon_recv(int fd, void* buf, size_t len);
+
+/* Writes exactly len bytes. Returns 0 or errno */
+int daemon_send(int fd, const void* buf, size_t len);
+
+/* Forwards a get or set to slimbookd when caller is not root and daemon is up.
+   Returns false if it could not, so caller goes to hardware itself */
+bool daemon_client_call(uint32_t op, uint32_t attr, uint32_t model, uint32_t* values, int* status);
+
+#endif
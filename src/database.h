@@ -0,0 +1,38 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_DATABASE_H
+#define SLB_DATABASE_H
+
+#include <cstdint>
+
+struct database_entry_t
+{
+    const char* product_name;
+    const char* product_sku;
+    const char* board_vendor;
+    uint32_t platform;
+    uint32_t model;
+};
+
+/* Known models, as DMI reports them, terminated by a zero model */
+extern database_entry_t database[];
+
+#endif
@@ -0,0 +1,191 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "fixture.h"
+#include "slimbook.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <cerrno>
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+/* writes data to dir + path, creating parent directories */
+static int put(const string& dir, const string& path, const string& data)
+{
+    filesystem::path file = dir + path;
+    error_code ec;
+
+    filesystem::create_directories(file.parent_path(), ec);
+
+    if (ec) {
+        return ec.value();
+    }
+
+    ofstream out(file, ios::binary | ios::trunc);
+    out<<data;
+    out.close();
+
+    return out.good() ? 0 : EIO;
+}
+
+/* appends an SMBIOS structure, formatted area holds everything after its 4 byte header */
+static void smbios_add(string& table, uint8_t type, uint16_t handle, const vector<uint8_t>& formatted, const vector<string>& strings)
+{
+    table += (char)type;
+    table += (char)(formatted.size() + 4);
+    table.append((const char*)&handle, 2);
+    table.append((const char*)formatted.data(), formatted.size());
+
+    for (const string& s : strings) {
+        table += s;
+        table += '\0';
+    }
+
+    /* structure ends with a double NUL, also when it has no strings */
+    if (strings.empty()) {
+        table += '\0';
+    }
+
+    table += '\0';
+}
+
+static string smbios_table()
+{
+    string table;
+
+    /* BIOS information */
+    vector<uint8_t> bios(0x18 - 4, 0);
+    bios[0x04 - 4] = 1;
+    bios[0x05 - 4] = 2;
+    bios[0x08 - 4] = 3;
+    smbios_add(table, 0, 0x0000, bios, {"INSYDE Corp.", "1.07.04", "03/14/2024"});
+
+    /* processor, 8 cores and 16 threads */
+    vector<uint8_t> cpu(0x30 - 4, 0);
+    cpu[0x10 - 4] = 1;
+    cpu[0x23 - 4] = 8;
+    cpu[0x25 - 4] = 16;
+    cpu[0x2A - 4] = 8;
+    smbios_add(table, 4, 0x0004, cpu, {"AMD Ryzen 7 8845HS w/ Radeon 780M Graphics"});
+
+    /* memory device, 16 GB of DDR5 at 5600 MT/s */
+    vector<uint8_t> mem(0x5C - 4, 0);
+    uint16_t size = 16384;
+    uint16_t speed = 5600;
+    memcpy(&mem[0x0C - 4], &size, 2);
+    mem[0x12 - 4] = 0x22;
+    memcpy(&mem[0x15 - 4], &speed, 2);
+    smbios_add(table, 17, 0x0011, mem, {});
+
+    smbios_add(table, 127, 0xFEFF, {}, {});
+
+    return table;
+}
+
+string fixture_name(const database_entry_t* entry)
+{
+    string name = entry->product_name;
+
+    if (entry->product_sku) {
+        name += string("-") + entry->product_sku;
+    }
+
+    for (char& c : name) {
+        if (!isalnum((unsigned char)c) and c != '-') {
+            c = '_';
+        }
+    }
+
+    return name;
+}
+
+int fixture_create(const string& dir, const database_entry_t* entry)
+{
+    vector<pair<string, string>> files = {
+        {"/sys/devices/virtual/dmi/id/product_name", string(entry->product_name) + "\n"},
+        {"/sys/devices/virtual/dmi/id/product_sku", string(entry->product_sku ? entry->product_sku : "") + "\n"},
+        {"/sys/devices/virtual/dmi/id/board_vendor", string(entry->board_vendor) + "\n"},
+        {"/sys/devices/virtual/dmi/id/bios_version", "1.07.04\n"},
+        {"/sys/devices/virtual/dmi/id/ec_firmware_release", "1.4\n"},
+        {"/sys/devices/virtual/dmi/id/product_serial", "FIXTURE00000001\n"},
+        {"/sys/firmware/dmi/tables/DMI", smbios_table()},
+
+        {"/proc/version", "Linux version 6.8.0-fixture (fixture@slimbook) #1 SMP PREEMPT_DYNAMIC\n"},
+        {"/proc/cmdline", "BOOT_IMAGE=/vmlinuz root=/dev/nvme0n1p2 ro quiet splash\n"},
+
+        {"/sys/class/power_supply/AC0/online", "1\n"},
+        {"/sys/class/power_supply/BAT0/capacity", "87\n"},
+        {"/sys/class/power_supply/BAT0/charge_now", "4350000\n"},
+        {"/sys/class/power_supply/BAT0/status", "Charging\n"},
+
+        {"/sys/class/hwmon/hwmon0/name", "k10temp\n"},
+        {"/sys/class/hwmon/hwmon0/temp1_input", "45250\n"},
+        {"/sys/class/hwmon/hwmon0/temp1_label", "Tctl\n"},
+
+        {"/sys/bus/pci/devices/0000:00:00.0/vendor", "0x1022\n"},
+        {"/sys/bus/pci/devices/0000:00:00.0/device", "0x14e8\n"},
+        {"/sys/bus/pci/devices/0000:00:00.0/subsystem_vendor", "0x1d05\n"},
+        {"/sys/bus/pci/devices/0000:00:00.0/subsystem_device", "0x1215\n"},
+        {"/sys/bus/pci/devices/0000:00:00.0/class", "0x060000\n"},
+        {"/sys/bus/pci/devices/0000:00:00.0/revision", "0x00\n"},
+    };
+
+    if (entry->platform == SLB_PLATFORM_QC71 or entry->platform == SLB_PLATFORM_CLEVO) {
+        files.push_back({"/sys/class/leds/rgb:kbd_backlight/brightness", "128\n"});
+        files.push_back({"/sys/class/leds/rgb:kbd_backlight/max_brightness", "255\n"});
+        files.push_back({"/sys/class/leds/rgb:kbd_backlight/multi_intensity", "255 255 255\n"});
+    }
+
+    if (entry->platform == SLB_PLATFORM_QC71) {
+        files.push_back({"/sys/module/qc71_laptop/version", "fixture\n"});
+        files.push_back({"/sys/devices/platform/qc71_laptop/manual_control", "0\n"});
+        files.push_back({"/sys/devices/platform/qc71_laptop/fn_lock", "0\n"});
+        files.push_back({"/sys/devices/platform/qc71_laptop/super_key_lock", "0\n"});
+        files.push_back({"/sys/devices/platform/qc71_laptop/silent_mode", "0\n"});
+        files.push_back({"/sys/devices/platform/qc71_laptop/turbo_mode", "0\n"});
+        files.push_back({"/sys/devices/platform/qc71_laptop/performance_mode", "1\n"});
+        files.push_back({"/sys/devices/platform/qc71_laptop/custom_tdp", "35 45 54\n"});
+        files.push_back({"/sys/class/hwmon/hwmon1/name", "qc71_laptop\n"});
+        files.push_back({"/sys/class/hwmon/hwmon1/fan1_input", "2350\n"});
+        files.push_back({"/sys/class/hwmon/hwmon1/fan2_input", "2100\n"});
+    }
+
+    if (entry->platform == SLB_PLATFORM_CLEVO) {
+        files.push_back({"/sys/module/clevo_platform/version", "fixture\n"});
+        files.push_back({"/sys/devices/platform/clevo_platform/color_left", "ffffff\n"});
+        files.push_back({"/sys/class/hwmon/hwmon1/name", "clevo_platform\n"});
+        files.push_back({"/sys/class/hwmon/hwmon1/fan1_input", "2350\n"});
+        files.push_back({"/sys/class/hwmon/hwmon1/fan2_input", "2100\n"});
+    }
+
+    for (const auto& file : files) {
+        int status = put(dir, file.first, file.second);
+
+        if (status != 0) {
+            return status;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_FIXTURE_H
+#define SLB_FIXTURE_H
+
+#include "database.h"
+
+#include <string>
+
+/*
+  Writes under dir the sysfs and procfs files the library reads for a
+  model: DMI ids and tables, platform module attributes, keyboard LEDs,
+  power supplies, hwmon and PCI. Point SLB_ROOT or slb_root_set at it to
+  run the library off real hardware.
+  Returns 0 or errno
+*/
+int fixture_create(const std::string& dir, const database_entry_t* entry);
+
+/* Gets a directory name for a model fixture, unique among known models */
+std::string fixture_name(const database_entry_t* entry);
+
+#endif
@@ -0,0 +1,384 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "hwmon.h"
+#include "common.h"
+#include "trace.h"
+#include "stats.h"
+
+#include <filesystem>
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <charconv>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SYSFS_HWMON "/sys/class/hwmon/"
+
+using namespace std;
+
+/* deque, so chips found by a rescan do not move the ones already handed out */
+static deque<hwmon_chip> chips;
+static bool chips_scanned = false;
+static uint32_t chips_generation = 0;
+static chrono::steady_clock::time_point chips_missed;
+static mutex chips_mutex;
+
+static const char* type_names[] = {"fan", "temp", "power", "in", "curr"};
+
+static hwmon_type _hwmon_parse_name(const string& file, int32_t* index, string* attr)
+{
+    for (int t = HWMON_FAN; t < HWMON_UNKNOWN; t++) {
+        size_t len = strlen(type_names[t]);
+
+        if (file.compare(0, len, type_names[t]) != 0) {
+            continue;
+        }
+
+        const char* first = file.c_str() + len;
+        const char* last = file.c_str() + file.size();
+        from_chars_result res = from_chars(first, last, *index);
+
+        if (res.ec != errc() or res.ptr == first or *res.ptr != '_') {
+            continue;
+        }
+
+        *attr = res.ptr + 1;
+
+        return (hwmon_type)t;
+    }
+
+    return HWMON_UNKNOWN;
+}
+
+/* dir is a system path, paths kept in registry are too so reads get root prefix applied once */
+static void _hwmon_scan_chip(const filesystem::path& dir)
+{
+    char buf[SLB_DEVICE_BUFFER_SIZE];
+    hwmon_chip chip;
+
+    if (read_device_buf((dir / "name").c_str(), buf, sizeof(buf)) != 0) {
+        return;
+    }
+
+    chip.name = buf;
+    chip.path = dir.string();
+    chip.present = true;
+
+    vector<string> files;
+    list_device_dir(chip.path.c_str(), files);
+
+    for (const string& file : files) {
+        string attr;
+        int32_t index;
+        hwmon_type type = _hwmon_parse_name(file, &index, &attr);
+
+        /* power meters may only provide an average */
+        if (type == HWMON_UNKNOWN or not (attr == "input" or (type == HWMON_POWER and attr == "average"))) {
+            continue;
+        }
+
+        if (attr == "average" and device_exists((dir / (string(type_names[type]) + to_string(index) + "_input")).c_str())) {
+            continue;
+        }
+
+        hwmon_sensor sensor;
+
+        sensor.chip = chip.name;
+        sensor.type = type;
+        sensor.index = index;
+        sensor.path = (dir / file).string();
+        sensor.fd = -1;
+
+        string label = string(type_names[type]) + to_string(index) + "_label";
+
+        if (read_device_buf((dir / label).c_str(), buf, sizeof(buf)) == 0) {
+            sensor.label = buf;
+        }
+
+        chip.sensors.push_back(sensor);
+    }
+
+    chips.push_back(chip);
+}
+
+/* chips come and go with their modules, caller holds chips_mutex */
+static void _hwmon_scan()
+{
+    char buf[SLB_DEVICE_BUFFER_SIZE];
+    vector<string> names;
+
+    list_device_dir(SYSFS_HWMON, names);
+
+    /* hwmonN numbers get reused, so a chip is still there only if its name is */
+    for (hwmon_chip& chip : chips) {
+        if (chip.present) {
+            string path = chip.path + "/name";
+            chip.present = read_device_buf(path.c_str(), buf, sizeof(buf)) == 0 and chip.name == buf;
+        }
+    }
+
+    for (const string& name : names) {
+        filesystem::path dir = filesystem::path(SYSFS_HWMON) / name;
+        bool known = false;
+
+        for (const hwmon_chip& chip : chips) {
+            if (chip.present and chip.path == dir.string()) {
+                known = true;
+                break;
+            }
+        }
+
+        if (!known) {
+            _hwmon_scan_chip(dir);
+        }
+    }
+
+    chips_scanned = true;
+}
+
+/* caller holds chips_mutex */
+static void _hwmon_update(bool missed)
+{
+    uint32_t generation = module_cache_generation();
+
+    if (!chips_scanned or generation != chips_generation) {
+        chips_generation = generation;
+        _hwmon_scan();
+        return;
+    }
+
+    if (missed) {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+        if (now - chips_missed >= chrono::milliseconds(HWMON_RESCAN_MS)) {
+            chips_missed = now;
+            _hwmon_scan();
+        }
+    }
+}
+
+/* caller holds chips_mutex */
+static hwmon_chip* _hwmon_find_chip(const char* name)
+{
+    for (hwmon_chip& chip : chips) {
+        if (chip.present and chip.name == name) {
+            return &chip;
+        }
+    }
+
+    return nullptr;
+}
+
+void hwmon_scan()
+{
+    lock_guard<mutex> lock(chips_mutex);
+
+    _hwmon_update(false);
+}
+
+void hwmon_reset()
+{
+    lock_guard<mutex> lock(chips_mutex);
+
+    for (hwmon_chip& chip : chips) {
+        for (hwmon_sensor& sensor : chip.sensors) {
+            if (sensor.fd >= 0) {
+                close(sensor.fd);
+            }
+        }
+    }
+
+    chips.clear();
+    chips_scanned = false;
+}
+
+hwmon_chip* hwmon_find_chip(const char* name)
+{
+    lock_guard<mutex> lock(chips_mutex);
+
+    _hwmon_update(false);
+
+    hwmon_chip* chip = _hwmon_find_chip(name);
+
+    /* driver may have been loaded after last scan with no listener to tell */
+    if (chip == nullptr) {
+        _hwmon_update(true);
+        chip = _hwmon_find_chip(name);
+    }
+
+    return chip;
+}
+
+/* chip sensors are filled before it is added to registry and never change, no lock needed */
+hwmon_sensor* hwmon_find_sensor(const char* chip, hwmon_type type, int32_t index)
+{
+    hwmon_chip* c = hwmon_find_chip(chip);
+
+    if (c == nullptr) {
+        return nullptr;
+    }
+
+    for (hwmon_sensor& sensor : c->sensors) {
+        if (sensor.type == type and sensor.index == index) {
+            return &sensor;
+        }
+    }
+
+    return nullptr;
+}
+
+hwmon_sensor* hwmon_find_label(const char* chip, hwmon_type type, const char* label)
+{
+    hwmon_chip* c = hwmon_find_chip(chip);
+
+    if (c == nullptr) {
+        return nullptr;
+    }
+
+    for (hwmon_sensor& sensor : c->sensors) {
+        if (sensor.type == type and sensor.label == label) {
+            return &sensor;
+        }
+    }
+
+    return nullptr;
+}
+
+vector<hwmon_sensor*> hwmon_sensors(hwmon_type type)
+{
+    lock_guard<mutex> lock(chips_mutex);
+    vector<hwmon_sensor*> sensors;
+
+    _hwmon_update(false);
+
+    for (hwmon_chip& chip : chips) {
+        if (!chip.present) {
+            continue;
+        }
+
+        for (hwmon_sensor& sensor : chip.sensors) {
+            if (sensor.type == type) {
+                sensors.push_back(&sensor);
+            }
+        }
+    }
+
+    return sensors;
+}
+
+static int _hwmon_parse(const char* buf, int64_t* value)
+{
+    const char* last = buf + strlen(buf);
+    from_chars_result res = from_chars(buf, last, *value);
+
+    return res.ec == errc() ? 0 : EINVAL;
+}
+
+int hwmon_read(hwmon_sensor* sensor, int64_t* value)
+{
+    char buf[SLB_DEVICE_BUFFER_SIZE];
+
+    if (sensor == nullptr or value == nullptr) {
+        return EINVAL;
+    }
+
+    ssize_t len = traced_read(TRACE_OP_READ, sensor->path.c_str(), buf, sizeof(buf) - 1, [&]() {
+        int fd;
+
+        /* concurrent first reads of a sensor must not both open it */
+        {
+            lock_guard<mutex> lock(chips_mutex);
+
+            if (sensor->fd < 0) {
+                char full[SLB_PATH_MAX];
+                sensor->fd = open(root_path(sensor->path.c_str(), full, sizeof(full)), O_RDONLY | O_CLOEXEC);
+                stats_syscalls(1);
+
+                if (sensor->fd < 0) {
+                    return (ssize_t)-errno;
+                }
+            }
+
+            fd = sensor->fd;
+        }
+
+        /* a sensor whose chip went away keeps its fd, kernel answers ENODEV */
+        ssize_t ret = pread(fd, buf, sizeof(buf) - 1, 0);
+        stats_syscalls(1);
+
+        return ret < 0 ? (ssize_t)-errno : ret;
+    });
+
+    if (len < 0) {
+        return -len;
+    }
+
+    buf[len] = 0;
+
+    return _hwmon_parse(buf, value);
+}
+
+device_batch* hwmon_batch_alloc(hwmon_sensor** sensors, size_t count)
+{
+    device_batch* batch = device_batch_alloc(count);
+
+    if (batch == nullptr) {
+        return nullptr;
+    }
+
+    for (size_t n = 0; n < count; n++) {
+        if (device_batch_add(batch, sensors[n]->path.c_str()) < 0) {
+            device_batch_free(batch);
+            return nullptr;
+        }
+    }
+
+    return batch;
+}
+
+int hwmon_batch_read(device_batch* batch, int64_t* values, int* status)
+{
+    int ret = device_batch_read(batch);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    int count = device_batch_count(batch);
+
+    for (int n = 0; n < count; n++) {
+        int st;
+        const char* buf = device_batch_value(batch, n, &st);
+
+        if (buf != nullptr) {
+            st = _hwmon_parse(buf, &values[n]);
+        }
+
+        if (status) {
+            status[n] = st;
+        }
+    }
+
+    return 0;
+}
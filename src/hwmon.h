@@ -0,0 +1,95 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_HWMON_H
+#define SLB_HWMON_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "stddef.h"
+
+typedef struct device_batch device_batch;
+
+/* minimum time between rescans triggered by lookups of missing chips */
+#define HWMON_RESCAN_MS 1000
+
+typedef enum {
+    HWMON_FAN,
+    HWMON_TEMP,
+    HWMON_POWER,
+    HWMON_IN,
+    HWMON_CURR,
+    HWMON_UNKNOWN
+} hwmon_type;
+
+struct hwmon_sensor {
+    std::string chip;
+    hwmon_type type;
+    /* N as in fanN_input */
+    int32_t index;
+    /* contents of typeN_label, empty if there is none */
+    std::string label;
+    std::string path;
+    /* kept open after first read, -1 until then */
+    int32_t fd;
+};
+
+struct hwmon_chip {
+    std::string name;
+    std::string path;
+    std::vector<hwmon_sensor> sensors;
+    /* false once its device went away, entry is kept as its sensors may still be referenced */
+    bool present;
+};
+
+/*
+  Enumerates /sys/class/hwmon. First call does the full scan, later ones
+  only pick up chips added or removed since, when the module listener saw
+  a uevent. Chips and sensors are never moved nor freed by a rescan.
+*/
+void hwmon_scan();
+
+/* Drops the registry, pointers returned so far are no longer valid */
+void hwmon_reset();
+
+/* Finds first present chip by name, a miss rescans at most every HWMON_RESCAN_MS */
+hwmon_chip* hwmon_find_chip(const char* name);
+
+/* Finds a sensor by chip name, type and index */
+hwmon_sensor* hwmon_find_sensor(const char* chip, hwmon_type type, int32_t index);
+
+/* Finds a sensor by chip name, type and label */
+hwmon_sensor* hwmon_find_label(const char* chip, hwmon_type type, const char* label);
+
+/* Gets every sensor of a type, from all present chips */
+std::vector<hwmon_sensor*> hwmon_sensors(hwmon_type type);
+
+/* Reads a sensor raw value (RPM, millidegrees, microwatts, millivolts or milliamps). Returns 0 or errno */
+int hwmon_read(hwmon_sensor* sensor, int64_t* value);
+
+/* Allocates a batch to read a subset of sensors together */
+device_batch* hwmon_batch_alloc(hwmon_sensor** sensors, size_t count);
+
+/* Reads all sensors in batch, status may be null. Returns 0 or errno */
+int hwmon_batch_read(device_batch* batch, int64_t* values, int* status);
+
+#endif
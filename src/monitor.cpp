@@ -0,0 +1,423 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "monitor.h"
+#include "slimbook.h"
+#include "hwmon.h"
+#include "common.h"
+
+#include <sys/timerfd.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+
+using namespace std;
+
+/* SMU is only asked for TDP this often when slimbookd is not publishing */
+#define MONITOR_TDP_MS 5000
+
+typedef struct monitor_field_t {
+    string name;
+    int64_t value;
+    bool valid;
+} monitor_field_t;
+
+/* fixed fields, hwmon sensors go after them */
+enum {
+    FIELD_FAN1,
+    FIELD_FAN2,
+    FIELD_BATTERY,
+    FIELD_CHARGE,
+    FIELD_BATTERY_STATUS,
+    FIELD_AC,
+    FIELD_TDP_SLOW,
+    FIELD_TDP_FAST,
+    FIELD_TDP_SUSTAINED,
+    FIELD_PROFILE,
+    FIELD_COUNT
+};
+
+static const char* field_names[FIELD_COUNT] = {
+    "fan1",
+    "fan2",
+    "battery",
+    "charge",
+    "battery_status",
+    "ac",
+    "tdp_slow",
+    "tdp_fast",
+    "tdp_sustained",
+    "profile"
+};
+
+static volatile sig_atomic_t monitor_stop = 0;
+
+static void monitor_signal(int)
+{
+    monitor_stop = 1;
+}
+
+static uint64_t monotonic_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void set_field(vector<monitor_field_t>& fields, int n, int64_t value)
+{
+    fields[n].value = value;
+    fields[n].valid = true;
+}
+
+/* fan getters report a missing sensor as -1 */
+static void set_fan(vector<monitor_field_t>& fields, int n, int status, uint32_t value)
+{
+    if (status == 0 and value != (uint32_t)-1) {
+        set_field(fields, n, value);
+    }
+}
+
+/*
+  Fills fixed fields. slimbookd telemetry is plain memory loads, so it is
+  preferred, otherwise library is asked directly
+*/
+static void sample_fixed(vector<monitor_field_t>& fields, uint32_t platform, bool tdp_due)
+{
+    slb_telemetry_t telemetry;
+
+    /* TDP values are kept between reads */
+    for (int n = 0; n < FIELD_COUNT; n++) {
+        if (tdp_due or n < FIELD_TDP_SLOW or n > FIELD_TDP_SUSTAINED) {
+            fields[n].valid = false;
+        }
+    }
+
+    if (slb_telemetry_read(&telemetry) == 0) {
+        if (telemetry.valid & SLB_TELEMETRY_QC71_PRIMARY_FAN) {
+            set_field(fields, FIELD_FAN1, telemetry.qc71_primary_fan);
+        }
+
+        if (telemetry.valid & SLB_TELEMETRY_QC71_SECONDARY_FAN) {
+            set_field(fields, FIELD_FAN2, telemetry.qc71_secondary_fan);
+        }
+
+        if (telemetry.valid & SLB_TELEMETRY_CLEVO_PRIMARY_FAN) {
+            set_field(fields, FIELD_FAN1, telemetry.clevo_primary_fan);
+        }
+
+        if (telemetry.valid & SLB_TELEMETRY_CLEVO_SECONDARY_FAN) {
+            set_field(fields, FIELD_FAN2, telemetry.clevo_secondary_fan);
+        }
+
+        if (telemetry.valid & SLB_TELEMETRY_BATTERY) {
+            set_field(fields, FIELD_BATTERY, telemetry.battery_capacity);
+            set_field(fields, FIELD_CHARGE, telemetry.battery_charge);
+            set_field(fields, FIELD_BATTERY_STATUS, telemetry.battery_status);
+        }
+
+        if (telemetry.valid & SLB_TELEMETRY_AC_STATE) {
+            set_field(fields, FIELD_AC, telemetry.ac_state);
+        }
+
+        if (telemetry.valid & SLB_TELEMETRY_TDP) {
+            set_field(fields, FIELD_TDP_SLOW, telemetry.tdp_slow);
+            set_field(fields, FIELD_TDP_FAST, telemetry.tdp_fast);
+            set_field(fields, FIELD_TDP_SUSTAINED, telemetry.tdp_sustained);
+        }
+    }
+    else {
+        uint32_t value = 0;
+        int status;
+
+        if (platform == SLB_PLATFORM_QC71) {
+            status = slb_qc71_primary_fan_get(&value);
+            set_fan(fields, FIELD_FAN1, status, value);
+            status = slb_qc71_secondary_fan_get(&value);
+            set_fan(fields, FIELD_FAN2, status, value);
+        }
+
+        if (platform == SLB_PLATFORM_CLEVO) {
+            status = slb_clevo_primary_fan_get(&value);
+            set_fan(fields, FIELD_FAN1, status, value);
+            status = slb_clevo_secondary_fan_get(&value);
+            set_fan(fields, FIELD_FAN2, status, value);
+        }
+
+        slb_sys_battery_info info = {};
+
+        if (slb_battery_info_get(&info) == 0) {
+            set_field(fields, FIELD_BATTERY, info.capacity);
+            set_field(fields, FIELD_CHARGE, info.charge);
+            set_field(fields, FIELD_BATTERY_STATUS, info.status);
+        }
+
+        int state = 0;
+
+        if (slb_info_get_ac_state(0, &state) == 0) {
+            set_field(fields, FIELD_AC, state);
+        }
+
+        /* an SMU transaction can sleep for 200 ms */
+        if (tdp_due) {
+            slb_tdp_info_t tdp = slb_info_get_tdp_info();
+            set_field(fields, FIELD_TDP_SLOW, tdp.slow);
+            set_field(fields, FIELD_TDP_FAST, tdp.fast);
+            set_field(fields, FIELD_TDP_SUSTAINED, tdp.sustained);
+        }
+    }
+
+    if (platform == SLB_PLATFORM_QC71) {
+        uint32_t profile;
+
+        if (slb_qc71_profile_get(&profile) == 0) {
+            set_field(fields, FIELD_PROFILE, profile);
+        }
+    }
+}
+
+static string sensor_name(const hwmon_sensor* sensor)
+{
+    string name = sensor->chip + "_";
+
+    if (sensor->label.empty()) {
+        name += (sensor->type == HWMON_TEMP ? "temp" : "power") + to_string(sensor->index);
+    }
+    else {
+        name += sensor->label;
+    }
+
+    /* keep names usable as JSON keys and shell words */
+    for (char& c : name) {
+        if (!isalnum((unsigned char)c) and c != '_' and c != '-') {
+            c = '_';
+        }
+    }
+
+    return name;
+}
+
+static void json_record(string& out, uint64_t timestamp, const vector<monitor_field_t>& fields, uint64_t changed)
+{
+    out = "{\"ts\":" + to_string(timestamp / 1000000);
+
+    for (size_t n = 0; n < fields.size(); n++) {
+        if (changed & (1ull << n)) {
+            out += ",\"" + fields[n].name + "\":";
+            out += fields[n].valid ? to_string(fields[n].value) : "null";
+        }
+    }
+
+    out += "}\n";
+}
+
+static void binary_record(string& out, uint64_t timestamp, const vector<monitor_field_t>& fields, uint64_t changed, uint64_t valid)
+{
+    out.assign((const char*)&timestamp, sizeof(timestamp));
+    out.append((const char*)&changed, sizeof(changed));
+    out.append((const char*)&valid, sizeof(valid));
+
+    for (size_t n = 0; n < fields.size(); n++) {
+        if (changed & valid & (1ull << n)) {
+            out.append((const char*)&fields[n].value, sizeof(int64_t));
+        }
+    }
+}
+
+static int write_all(const string& data)
+{
+    size_t done = 0;
+
+    while (done < data.size()) {
+        ssize_t len = write(STDOUT_FILENO, data.data() + done, data.size() - done);
+
+        if (len < 0) {
+            if (errno == EINTR and !monitor_stop) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        done += len;
+    }
+
+    return 0;
+}
+
+int monitor_run(uint32_t interval_ms, int format)
+{
+    if (interval_ms == 0) {
+        return EINVAL;
+    }
+
+    vector<monitor_field_t> fields;
+
+    for (int n = 0; n < FIELD_COUNT; n++) {
+        fields.push_back({field_names[n], 0, false});
+    }
+
+    /* sensor files stay open for the whole run, reads are a pread each */
+    vector<hwmon_sensor*> sensors = hwmon_sensors(HWMON_TEMP);
+    vector<hwmon_sensor*> power = hwmon_sensors(HWMON_POWER);
+    sensors.insert(sensors.end(), power.begin(), power.end());
+
+    if (sensors.size() > MONITOR_MAX_FIELDS - FIELD_COUNT) {
+        sensors.resize(MONITOR_MAX_FIELDS - FIELD_COUNT);
+    }
+
+    for (hwmon_sensor* sensor : sensors) {
+        fields.push_back({sensor_name(sensor), 0, false});
+    }
+
+    device_batch* batch = nullptr;
+    vector<int64_t> values(sensors.size());
+    vector<int> status(sensors.size());
+
+    if (!sensors.empty()) {
+        batch = hwmon_batch_alloc(sensors.data(), sensors.size());
+    }
+
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+    if (timer < 0) {
+        return errno;
+    }
+
+    /* absolute period, a late wakeup does not push next ones */
+    struct itimerspec period;
+    period.it_interval.tv_sec = interval_ms / 1000;
+    period.it_interval.tv_nsec = (interval_ms % 1000) * 1000000;
+    period.it_value = period.it_interval;
+
+    if (timerfd_settime(timer, 0, &period, nullptr) < 0) {
+        int ret = errno;
+        close(timer);
+        return ret;
+    }
+
+    /* no SA_RESTART, so read on timer returns on signals */
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = monitor_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    uint32_t platform = slb_info_get_platform();
+    uint32_t tdp_ticks = MONITOR_TDP_MS / interval_ms;
+    uint64_t tick = 0;
+    uint64_t previous_valid = 0;
+    vector<int64_t> previous(fields.size());
+    string out;
+    int ret = 0;
+
+    if (format == MONITOR_FORMAT_BINARY) {
+        uint32_t header[3] = {MONITOR_MAGIC, MONITOR_VERSION, (uint32_t)fields.size()};
+        out.assign((const char*)header, sizeof(header));
+
+        for (const monitor_field_t& field : fields) {
+            out.append(field.name.c_str(), field.name.size() + 1);
+        }
+
+        ret = write_all(out);
+    }
+
+    while (ret == 0 and !monitor_stop) {
+        sample_fixed(fields, platform, tdp_ticks == 0 or tick % tdp_ticks == 0);
+
+        if (batch) {
+            hwmon_batch_read(batch, values.data(), status.data());
+
+            for (size_t n = 0; n < sensors.size(); n++) {
+                fields[FIELD_COUNT + n].valid = status[n] == 0;
+                fields[FIELD_COUNT + n].value = values[n];
+            }
+        }
+
+        uint64_t timestamp = monotonic_ns();
+        uint64_t valid = 0;
+        uint64_t changed = 0;
+
+        for (size_t n = 0; n < fields.size(); n++) {
+            uint64_t bit = 1ull << n;
+
+            if (fields[n].valid) {
+                valid |= bit;
+
+                if (tick == 0 or !(previous_valid & bit) or previous[n] != fields[n].value) {
+                    changed |= bit;
+                }
+
+                previous[n] = fields[n].value;
+            }
+            else if (previous_valid & bit) {
+                changed |= bit;
+            }
+        }
+
+        previous_valid = valid;
+
+        if (changed != 0 or tick == 0) {
+            if (format == MONITOR_FORMAT_BINARY) {
+                binary_record(out, timestamp, fields, changed, valid);
+            }
+            else {
+                json_record(out, timestamp, fields, changed);
+            }
+
+            ret = write_all(out);
+        }
+
+        tick++;
+
+        uint64_t expirations;
+
+        while (ret == 0 and !monitor_stop) {
+            if (read(timer, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                break;
+            }
+
+            if (errno != EINTR) {
+                ret = errno;
+            }
+        }
+    }
+
+    close(timer);
+
+    if (batch) {
+        device_batch_free(batch);
+    }
+
+    /* stopped by a signal or a closed pipe, both are a normal end */
+    if (ret == EPIPE or ret == EINTR) {
+        ret = 0;
+    }
+
+    return ret;
+}
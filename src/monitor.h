@@ -0,0 +1,58 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_MONITOR_H
+#define SLB_MONITOR_H
+
+#include <cstdint>
+
+#define MONITOR_FORMAT_JSON     0
+#define MONITOR_FORMAT_BINARY   1
+
+#define MONITOR_DEFAULT_INTERVAL_MS 1000
+
+/* fields are tracked with a 64 bit mask, further hwmon sensors are ignored */
+#define MONITOR_MAX_FIELDS 64
+
+/* binary stream magic and version */
+#define MONITOR_MAGIC   0x4d424c53
+#define MONITOR_VERSION 1
+
+/*
+  Samples fans, battery, AC, TDP, profile and every hwmon temperature and
+  power sensor each interval_ms, until SIGINT, SIGTERM or stdout is closed.
+  Only fields that changed since previous sample are written, first sample
+  has all of them. Temperatures are in millidegrees and power in microwatts,
+  as hwmon reports them.
+
+  JSON format is one object per line: {"ts":MS,"name":value,...}, ts being
+  CLOCK_MONOTONIC milliseconds and null marking a field that went away.
+
+  Binary format starts with u32 MONITOR_MAGIC, u32 MONITOR_VERSION, u32
+  field count and NUL terminated field names. Then, for each sample with
+  changes: u64 CLOCK_MONOTONIC nanoseconds, u64 changed mask, u64 valid
+  mask and an i64 for each bit set in both masks, lowest bit first. All
+  in host byte order.
+
+  Returns 0 or errno
+*/
+int monitor_run(uint32_t interval_ms, int format);
+
+#endif
@@ -20,6 +20,8 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "pci.h"
 #include "common.h"
+#include "trace.h"
+#include "stats.h"
 
 #include "stdlib.h"
 #include "stdio.h"
@@ -28,6 +30,10 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <string.h>
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <tuple>
+#include <cerrno>
 
 static void _pci_get_info(pci_dev*, std::string, std::string&);
 
@@ -42,27 +48,61 @@ static void _init_sysfs_pci(pci_access* a){
 static int32_t _pci_prep_rw(pci_dev* d, int32_t type){
     pci_access* a = d->access;
 
+    /* replayed config space is never opened */
+    if(trace_mode() == TRACE_REPLAY){
+        return -1;
+    }
+
     if(a->fd == INT32_MAX || a->fd < 0){
         std::string str;
 
         _pci_get_info(d, "config", str);
 
-        a->fd = open(str.c_str(), type == 0 ? O_RDONLY : O_RDWR);
+        a->fd = open(root_path(str).c_str(), type == 0 ? O_RDONLY : O_RDWR);
+        stats_syscalls(1);
     }
  
     return a->fd;
 }
 
+/* trace key for an access to config space at pos */
+static std::string _pci_trace_key(pci_dev* d, int32_t pos){
+    std::string str;
+    char offset[16];
+
+    _pci_get_info(d, "config", str);
+    snprintf(offset, sizeof(offset), "@%x", pos);
+
+    return str + offset;
+}
+
 static void _read_sysfs_pci(pci_dev* d, int32_t pos, char* buf, size_t len){
-    int32_t fd = _pci_prep_rw(d, 0);
-    
-    pread(fd, buf, len, pos);
+    if(trace_mode() == TRACE_OFF){
+        pread(_pci_prep_rw(d, 0), buf, len, pos);
+        stats_syscalls(1);
+        return;
+    }
+
+    traced_read(TRACE_OP_PCI_READ, _pci_trace_key(d, pos).c_str(), buf, len, [&](){
+        ssize_t ret = pread(_pci_prep_rw(d, 0), buf, len, pos);
+        stats_syscalls(1);
+
+        return ret < 0 ? (ssize_t)-errno : ret;
+    });
 }
 
 static size_t _write_sysfs_pci(pci_dev* d, int32_t pos, char* buf, size_t len){
-    int32_t fd = _pci_prep_rw(d, 1);
+    if(trace_mode() == TRACE_OFF){
+        stats_syscalls(1);
+        return pwrite(_pci_prep_rw(d, 1), buf, len, pos);
+    }
 
-    return pwrite(fd, buf, len, pos); 
+    int status = traced_call(TRACE_OP_PCI_WRITE, _pci_trace_key(d, pos).c_str(), buf, len, [&](){
+        stats_syscalls(1);
+        return pwrite(_pci_prep_rw(d, 1), buf, len, pos) < 0 ? errno : 0;
+    });
+
+    return status == 0 ? len : 0;
 }
 
 pci_procs sysfs_procs = {
@@ -165,6 +205,74 @@ void pci_init_dev(pci_access* a){
     }
 }
 
+int pci_enumerate(pci_access* a, std::vector<pci_device_info>& devices){
+    if(a == nullptr){
+        return EINVAL;
+    }
+
+    std::vector<std::string> names;
+    int status = list_device_dir((a->path + "/devices").c_str(), names);
+
+    if(status != 0){
+        return status;
+    }
+
+    for(const std::string& name : names){
+        /* system path, read_device_u32 resolves it under root prefix */
+        std::string base = a->path + "/devices/" + name + "/";
+        pci_device_info info = {};
+        uint32_t value;
+        unsigned int dom, bus, dev, fun;
+
+        if(sscanf(name.c_str(), "%x:%x:%x.%x", &dom, &bus, &dev, &fun) != 4){
+            continue;
+        }
+
+        info.dom = dom;
+        info.bus = bus;
+        info.dev = dev;
+        info.fun = fun;
+
+        if(read_device_u32((base + "vendor").c_str(), &value, 16) == 0){
+            info.vendor = value;
+        }
+
+        if(read_device_u32((base + "device").c_str(), &value, 16) == 0){
+            info.device = value;
+        }
+
+        if(read_device_u32((base + "subsystem_vendor").c_str(), &value, 16) == 0){
+            info.subsystem_vendor = value;
+        }
+
+        if(read_device_u32((base + "subsystem_device").c_str(), &value, 16) == 0){
+            info.subsystem_device = value;
+        }
+
+        if(read_device_u32((base + "class").c_str(), &value, 16) == 0){
+            info.class_code = value;
+        }
+
+        if(read_device_u32((base + "revision").c_str(), &value, 16) == 0){
+            info.revision = value;
+        }
+
+        std::string driver;
+
+        if(read_device_link((base + "driver").c_str(), driver) == 0){
+            info.driver = std::filesystem::path(driver).filename().string();
+        }
+
+        devices.push_back(info);
+    }
+
+    std::sort(devices.begin(), devices.end(), [](const pci_device_info& x, const pci_device_info& y){
+        return std::tie(x.dom, x.bus, x.dev, x.fun) < std::tie(y.dom, y.bus, y.dev, y.fun);
+    });
+
+    return 0;
+}
+
 void pci_cleanup(pci_dev* dev){
     close(dev->access->fd);
     free(dev->access);
@@ -23,6 +23,7 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include <cstdint>
 #include <string>
+#include <vector>
 #include "stddef.h"
 
 typedef struct pci_access pci_access;
@@ -55,6 +56,22 @@ struct pci_dev {
     pci_procs* procs; 
 };
 
+typedef struct pci_device_info {
+    int32_t dom;
+    int32_t bus;
+    int32_t dev;
+    int32_t fun;
+    uint16_t vendor;
+    uint16_t device;
+    uint16_t subsystem_vendor;
+    uint16_t subsystem_device;
+    /* base class, subclass and programming interface */
+    uint32_t class_code;
+    uint8_t revision;
+    /* bound kernel driver, empty if none */
+    std::string driver;
+} pci_device_info;
+
 /* Allocates a pci_access struct */
 pci_access* pci_access_alloc();
 
@@ -82,6 +99,9 @@ void pci_write_short(pci_dev* dev, int32_t pos, uint16_t data);
 /* Writes four bytes from pci_dev at pos */
 void pci_write_long(pci_dev* dev, int32_t pos, uint32_t data);
 
+/* Lists devices on the bus of an initialised pci_access, sorted by address. Returns 0 or errno */
+int pci_enumerate(pci_access* a, std::vector<pci_device_info>& devices);
+
 /* Frees the pci_dev */
 void pci_cleanup(pci_dev* dev);
 
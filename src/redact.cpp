@@ -0,0 +1,480 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "redact.h"
+#include "common.h"
+
+#include <sys/utsname.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <array>
+#include <queue>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+/* literals shorter than this would hit ordinary words */
+#define REDACT_MIN_LITERAL 3
+
+/* first uid given to people, as in login.defs */
+#define REDACT_MIN_UID 1000
+
+#define TAG_SERIAL "[serial]"
+#define TAG_HOST "[host]"
+#define TAG_USER "[user]"
+#define TAG_SSID "[ssid]"
+#define TAG_MAC "[mac]"
+#define TAG_IPV4 "[ipv4]"
+#define TAG_IPV6 "[ipv6]"
+#define TAG_UUID "[uuid]"
+
+/* Aho-Corasick automaton, with a full transition table so scanning is one lookup per byte */
+struct redactor_t
+{
+    vector<array<int32_t, 256>> next;
+    vector<int32_t> fail;
+    /* longest literal ending at state, 0 if none */
+    vector<uint32_t> length;
+    vector<const char*> tag;
+    /* bytes that may start a literal or an address, the rest are skipped from root state */
+    array<bool, 256> interesting;
+};
+
+/* no ctype here, it goes through locale for every byte */
+static inline bool is_hex(unsigned char c)
+{
+    return (c >= '0' and c <= '9') or ((c | 0x20) >= 'a' and (c | 0x20) <= 'f');
+}
+
+static inline bool is_word(unsigned char c)
+{
+    return (c >= '0' and c <= '9') or ((c | 0x20) >= 'a' and (c | 0x20) <= 'z') or c == '_' or c >= 0x80;
+}
+
+/* bytes that may be part of an address or uuid */
+static inline bool is_token(unsigned char c)
+{
+    return is_hex(c) or c == ':' or c == '.' or c == '-';
+}
+
+static int32_t add_state(redactor_t* r)
+{
+    array<int32_t, 256> row;
+
+    row.fill(-1);
+    r->next.push_back(row);
+    r->fail.push_back(0);
+    r->length.push_back(0);
+    r->tag.push_back(nullptr);
+
+    return r->next.size() - 1;
+}
+
+static void redactor_add(redactor_t* r, const string& literal, const char* tag)
+{
+    if (literal.size() < REDACT_MIN_LITERAL) {
+        return;
+    }
+
+    int32_t state = 0;
+
+    for (unsigned char c : literal) {
+        if (r->next[state][c] < 0) {
+            int32_t child = add_state(r);
+            r->next[state][c] = child;
+        }
+
+        state = r->next[state][c];
+    }
+
+    if (r->length[state] < literal.size()) {
+        r->length[state] = literal.size();
+        r->tag[state] = tag;
+    }
+}
+
+/* fills failure links and turns trie into a complete transition table */
+static void build(redactor_t* r)
+{
+    queue<int32_t> pending;
+
+    for (int c = 0; c < 256; c++) {
+        int32_t child = r->next[0][c];
+
+        if (child < 0) {
+            r->next[0][c] = 0;
+        }
+        else {
+            r->fail[child] = 0;
+            pending.push(child);
+        }
+    }
+
+    while (!pending.empty()) {
+        int32_t state = pending.front();
+        pending.pop();
+
+        /* a literal ending in a suffix ends here too */
+        if (r->length[state] == 0) {
+            r->length[state] = r->length[r->fail[state]];
+            r->tag[state] = r->tag[r->fail[state]];
+        }
+
+        for (int c = 0; c < 256; c++) {
+            int32_t child = r->next[state][c];
+
+            if (child < 0) {
+                r->next[state][c] = r->next[r->fail[state]][c];
+            }
+            else {
+                r->fail[child] = r->next[r->fail[state]][c];
+                pending.push(child);
+            }
+        }
+    }
+
+    for (int c = 0; c < 256; c++) {
+        r->interesting[c] = r->next[0][c] != 0 or is_token(c);
+    }
+}
+
+static bool generic_value(const string& value)
+{
+    static const char* generic[] = {"Not Specified", "Not Applicable", "To be filled by O.E.M.",
+                                    "Default string", "System Serial Number", "None", "N/A", nullptr};
+
+    for (int n = 0; generic[n]; n++) {
+        if (value == generic[n]) {
+            return true;
+        }
+    }
+
+    return value.find_first_not_of("0 ") == string::npos;
+}
+
+redactor_t* redactor_alloc()
+{
+    redactor_t* r = new redactor_t();
+
+    add_state(r);
+
+    for (const char* attr : {"product_serial", "board_serial", "chassis_serial"}) {
+        char buf[SLB_DEVICE_BUFFER_SIZE];
+
+        if (read_device_buf((string("/sys/class/dmi/id/") + attr).c_str(), buf, sizeof(buf)) == 0 and !generic_value(buf)) {
+            redactor_add(r, buf, TAG_SERIAL);
+        }
+    }
+
+    utsname uts;
+
+    if (uname(&uts) == 0 and string(uts.nodename) != "localhost") {
+        redactor_add(r, uts.nodename, TAG_HOST);
+    }
+
+    ifstream passwd("/etc/passwd");
+    string line;
+
+    /* name:password:uid:gid:gecos:home:shell */
+    while (getline(passwd, line)) {
+        vector<string> fields;
+        size_t start = 0;
+        size_t colon;
+
+        while ((colon = line.find(':', start)) != string::npos) {
+            fields.push_back(line.substr(start, colon - start));
+            start = colon + 1;
+        }
+
+        fields.push_back(line.substr(start));
+
+        uint32_t uid;
+
+        if (fields.size() < 7 or parse_u32(fields[2].c_str(), &uid) != 0 or uid < REDACT_MIN_UID or uid == 65534) {
+            continue;
+        }
+
+        redactor_add(r, fields[0], TAG_USER);
+        redactor_add(r, fields[4].substr(0, fields[4].find(',')), TAG_USER);
+    }
+
+    error_code ec;
+
+    for (const auto& entry : filesystem::directory_iterator("/etc/NetworkManager/system-connections", ec)) {
+        ifstream connection(entry.path());
+
+        while (getline(connection, line)) {
+            if (line.compare(0, 5, "ssid=") == 0) {
+                redactor_add(r, line.substr(5), TAG_SSID);
+            }
+        }
+    }
+
+    build(r);
+
+    return r;
+}
+
+void redactor_free(redactor_t* r)
+{
+    delete r;
+}
+
+/* xx:xx:xx:xx:xx:xx or with dashes */
+static bool match_mac(const char* s, size_t len)
+{
+    if (len != 17) {
+        return false;
+    }
+
+    for (size_t n = 0; n < len; n++) {
+        if (n % 3 == 2 ? (s[n] != s[2] or (s[n] != ':' and s[n] != '-')) : !is_hex(s[n])) {
+            return false;
+        }
+    }
+
+    /* zero and broadcast addresses say nothing about anyone */
+    return strncmp(s, "00:00:00:00:00:00", 17) != 0 and strncasecmp(s, "ff:ff:ff:ff:ff:ff", 17) != 0;
+}
+
+static bool match_uuid(const char* s, size_t len)
+{
+    if (len != 36) {
+        return false;
+    }
+
+    for (size_t n = 0; n < len; n++) {
+        bool dash = n == 8 or n == 13 or n == 18 or n == 23;
+
+        if (dash ? s[n] != '-' : !is_hex(s[n])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool match_ipv4(const char* s, size_t len)
+{
+    int parts = 0;
+    size_t n = 0;
+
+    while (n < len) {
+        uint32_t value = 0;
+        size_t digits = 0;
+
+        while (n < len and s[n] >= '0' and s[n] <= '9' and digits < 4) {
+            value = value * 10 + (s[n] - '0');
+            digits++;
+            n++;
+        }
+
+        if (digits == 0 or digits > 3 or value > 255) {
+            return false;
+        }
+
+        parts++;
+
+        if (n < len) {
+            if (s[n] != '.' or parts == 4) {
+                return false;
+            }
+
+            n++;
+        }
+    }
+
+    if (parts != 4) {
+        return false;
+    }
+
+    /* loopback and unspecified addresses are kept, they help debugging */
+    return strncmp(s, "127.", 4) != 0 and !(len == 7 and strncmp(s, "0.0.0.0", 7) == 0);
+}
+
+static bool match_ipv6(const char* s, size_t len)
+{
+    int groups = 0;
+    int colons = 0;
+    bool compressed = false;
+    size_t digits = 0;
+
+    for (size_t n = 0; n < len; n++) {
+        if (s[n] == ':') {
+            colons++;
+
+            if (n + 1 < len and s[n + 1] == ':') {
+                if (compressed) {
+                    return false;
+                }
+
+                compressed = true;
+            }
+
+            if (digits > 0) {
+                groups++;
+            }
+
+            digits = 0;
+        }
+        else if (is_hex(s[n]) and ++digits <= 4) {
+            continue;
+        }
+        else {
+            return false;
+        }
+    }
+
+    if (digits > 0) {
+        groups++;
+    }
+
+    if (colons < 2 or groups > 8 or (!compressed and groups != 8)) {
+        return false;
+    }
+
+    /* loopback and unspecified */
+    return !(len == 3 and strncmp(s, "::1", 3) == 0) and !(len == 2 and strncmp(s, "::", 2) == 0);
+}
+
+static const char* match_token(const char* s, size_t len)
+{
+    if (match_mac(s, len)) {
+        return TAG_MAC;
+    }
+
+    if (match_uuid(s, len)) {
+        return TAG_UUID;
+    }
+
+    if (match_ipv4(s, len)) {
+        return TAG_IPV4;
+    }
+
+    if (match_ipv6(s, len)) {
+        return TAG_IPV6;
+    }
+
+    return nullptr;
+}
+
+/* classifies a run of token bytes, returns new copied offset */
+static size_t redact_token(const char* data, size_t size, size_t start, size_t end, size_t copied, string& out)
+{
+    /* sentence punctuation around an address is not part of it */
+    while (end > start and (data[end - 1] == '.' or data[end - 1] == '-' or
+           (data[end - 1] == ':' and (end - start < 2 or data[end - 2] != ':')))) {
+        end--;
+    }
+
+    if (start < end and data[start] == ':' and (end - start < 2 or data[start + 1] != ':')) {
+        start++;
+    }
+
+    if ((start > 0 and is_word(data[start - 1])) or (end < size and is_word(data[end]))) {
+        return copied;
+    }
+
+    const char* tag = match_token(data + start, end - start);
+
+    if (!tag) {
+        return copied;
+    }
+
+    out.append(data + copied, start - copied);
+    out.append(tag);
+
+    return end;
+}
+
+void redact(const redactor_t* r, string& text)
+{
+    const char* data = text.data();
+    size_t size = text.size();
+    string out;
+    /* text before this offset is already in out, or replaced */
+    size_t copied = 0;
+    /* end of current run of token bytes, they are classified once at run start */
+    size_t run_end = 0;
+    int32_t state = 0;
+
+    for (size_t n = 0; n < size; n++) {
+        if (state == 0) {
+            while (n < size and !r->interesting[(unsigned char)data[n]]) {
+                n++;
+            }
+
+            if (n == size) {
+                break;
+            }
+        }
+
+        unsigned char c = data[n];
+
+        if (n >= run_end and is_token(c)) {
+            bool separated = false;
+
+            run_end = n;
+
+            while (run_end < size and is_token(data[run_end])) {
+                separated |= !is_hex(data[run_end]);
+                run_end++;
+            }
+
+            /* plain words and numbers, by far the most common runs, are no address */
+            if (separated and n >= copied) {
+                copied = redact_token(data, size, n, run_end, copied, out);
+            }
+        }
+
+        state = r->next[state][c];
+
+        uint32_t length = r->length[state];
+
+        if (length == 0) {
+            continue;
+        }
+
+        size_t start = n + 1 - length;
+
+        if (start < copied) {
+            continue;
+        }
+
+        if ((start > 0 and is_word(data[start - 1])) or (n + 1 < size and is_word(data[n + 1]))) {
+            continue;
+        }
+
+        out.append(data + copied, start - copied);
+        out.append(r->tag[state]);
+        copied = n + 1;
+    }
+
+    /* nothing found, text stays untouched */
+    if (copied == 0) {
+        return;
+    }
+
+    out.append(data + copied, size - copied);
+    text = std::move(out);
+}
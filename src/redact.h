@@ -0,0 +1,40 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_REDACT_H
+#define SLB_REDACT_H
+
+#include <string>
+
+typedef struct redactor_t redactor_t;
+
+/*
+  Builds a redactor for this machine: DMI serials, hostname, user names
+  and known wifi SSIDs are matched as literals, MAC, IPv4, IPv6 addresses
+  and UUIDs by shape
+*/
+redactor_t* redactor_alloc();
+
+/* Replaces every private token in text, in a single pass */
+void redact(const redactor_t* redactor, std::string& text);
+
+void redactor_free(redactor_t* redactor);
+
+#endif
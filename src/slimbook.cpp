@@ -23,6 +23,12 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "common.h"
 #include "amdsmu.h"
 #include "pci.h"
+#include "hwmon.h"
+#include "daemon.h"
+#include "database.h"
+#include "trace.h"
+#include "stats.h"
+#include "timeline.h"
 
 #include <cpuid.h>
 #include <sys/sysinfo.h>
@@ -51,15 +57,6 @@ using namespace std;
 
 thread_local std::string buffer;
 
-struct database_entry_t
-{
-    const char* product_name;
-    const char* product_sku;
-    const char* board_vendor;
-    uint32_t platform;
-    uint32_t model;
-};
-
 database_entry_t database [] = {
     {"PROX-AMD", 0, "SLIMBOOK", SLB_PLATFORM_QC71, SLB_MODEL_PROX_AMD},
     {"PROX15-AMD", 0, "SLIMBOOK", SLB_PLATFORM_QC71, SLB_MODEL_PROX_15_AMD},
@@ -150,35 +147,6 @@ uint32_t info_platform;
 uint32_t info_model;
 int32_t info_confidence;
 
-static vector<string> split(string input,char sep)
-{
-    vector<string> tmp;
-    bool knee = false;
-    string current;
-    
-    for (char c:input) {
-        
-        if (c != sep) {
-            current.push_back(c);
-            knee = true;
-        }
-        else {
-            if (knee == true) {
-                tmp.push_back(current);
-                current="";
-                knee = false;
-            }
-            
-        }
-    }
-    
-    if (current.size() > 0) {
-        tmp.push_back(current);
-    }
-    
-    return tmp;
-}
-
 static int min3i(int a,int b,int c)
 {
     if (a <= b && a <= c) {
@@ -269,6 +237,34 @@ static uint32_t get_model_platform(uint32_t model)
     return SLB_PLATFORM_UNKNOWN;
 }
 
+/* slimbookd only serves the model it detected, any other one is tried directly */
+static bool _client_model(uint32_t model)
+{
+    return model == 0 or model == slb_info_get_model();
+}
+
+/* Unprivileged callers are served by slimbookd when it is running */
+static bool _client_get(uint32_t attr, uint32_t model, uint32_t* out, int count, int* status)
+{
+    uint32_t values[DAEMON_VALUES] = {0};
+    
+    if (!_client_model(model) or !daemon_client_call(DAEMON_OP_GET, attr, model, values, status)) {
+        return false;
+    }
+    
+    /* some getters fill a fallback value even when they fail */
+    memcpy(out, values, count * sizeof(uint32_t));
+    
+    return true;
+}
+
+static bool _client_set(uint32_t attr, uint32_t model, uint32_t v0, uint32_t v1, uint32_t v2, int* status)
+{
+    uint32_t values[DAEMON_VALUES] = {v0, v1, v2, 0};
+    
+    return _client_model(model) and daemon_client_call(DAEMON_OP_SET, attr, model, values, status);
+}
+
 static void _get_info_dev(string type, string* str){
     try{
         read_device(SYSFS_DMI + type, *str);
@@ -280,8 +276,10 @@ static void _get_info_dev(string type, string* str){
 
 int32_t slb_info_retrieve()
 {
+    STATS_CALL();
+    
     if (info_cached) {
-        return 0;
+        STATS_RETURN(0);
     }
 
     _get_info_dev("product_name", &info_product);
@@ -354,7 +352,7 @@ int32_t slb_info_retrieve()
 
             info_cached = true;
             
-            return 1;
+            STATS_RETURN(1);
         }
     }
     
@@ -363,11 +361,13 @@ int32_t slb_info_retrieve()
     
     info_cached = true;
     
-    return 0;
+    STATS_RETURN(0);
 }
 
 int32_t slb_info_confidence()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_confidence;
@@ -375,6 +375,8 @@ int32_t slb_info_confidence()
 
 const char* slb_info_product_name()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_product.c_str();
@@ -382,6 +384,8 @@ const char* slb_info_product_name()
 
 const char* slb_info_product_sku()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_sku.c_str();
@@ -389,6 +393,8 @@ const char* slb_info_product_sku()
 
 const char* slb_info_board_vendor()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_vendor.c_str();
@@ -396,6 +402,8 @@ const char* slb_info_board_vendor()
 
 const char* slb_info_product_serial()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_serial.c_str();
@@ -403,6 +411,8 @@ const char* slb_info_product_serial()
 
 const char* slb_info_bios_version()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_bios_version.c_str();
@@ -410,6 +420,8 @@ const char* slb_info_bios_version()
 
 const char* slb_info_ec_firmware_release()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_ec_firmware_release.c_str();
@@ -417,6 +429,8 @@ const char* slb_info_ec_firmware_release()
 
 uint32_t slb_info_get_model()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
     
     return info_model;
@@ -424,11 +438,15 @@ uint32_t slb_info_get_model()
 
 uint32_t slb_info_get_family()
 {
+    STATS_CALL();
+    
     return slb_info_get_model() & SLB_FAMILY_MASK;
 }
 
 const char* slb_info_get_family_name()
 {
+    STATS_CALL();
+    
     uint32_t family = slb_info_get_family();
     
     family_t* f = family_database;
@@ -447,6 +465,8 @@ const char* slb_info_get_family_name()
 
 uint32_t slb_info_get_platform()
 {
+    STATS_CALL();
+    
     slb_info_retrieve();
 
     return info_platform;
@@ -454,6 +474,8 @@ uint32_t slb_info_get_platform()
 
 uint32_t slb_info_find_platform(uint32_t model)
 {
+    STATS_CALL();
+    
     database_entry_t* entry = database;
     
     while (entry->model > 0) {
@@ -469,6 +491,8 @@ uint32_t slb_info_find_platform(uint32_t model)
 
 uint32_t slb_info_is_module_loaded()
 {
+    STATS_CALL();
+    
     uint32_t platform = slb_info_get_platform();
     
     if (platform == SLB_PLATFORM_UNKNOWN) {
@@ -483,23 +507,28 @@ uint32_t slb_info_is_module_loaded()
         return SLB_MODULE_NOT_NEEDED;
     }
 
-    vector<string> modules = get_modules();
+    if (platform == SLB_PLATFORM_QC71 and module_loaded(MODULE_QC71)) {
+        return SLB_MODULE_LOADED;
+    }
     
-    for (string mod : modules) {
-        if (platform == SLB_PLATFORM_QC71 and mod == MODULE_QC71) {
-            return SLB_MODULE_LOADED;
-        }
-        
-        if (platform == SLB_PLATFORM_CLEVO and mod == MODULE_CLEVO) {
-            return SLB_MODULE_LOADED;
-        }
+    if (platform == SLB_PLATFORM_CLEVO and module_loaded(MODULE_CLEVO)) {
+        return SLB_MODULE_LOADED;
     }
     
     return SLB_MODULE_NOT_LOADED;
 }
 
+int slb_info_module_listener_start()
+{
+    STATS_CALL();
+    
+    STATS_RETURN(module_listener_start());
+}
+
 int64_t slb_info_uptime()
 {
+    STATS_CALL();
+    
     struct sysinfo info;
     
     sysinfo(&info);
@@ -509,6 +538,8 @@ int64_t slb_info_uptime()
 
 const char* slb_info_kernel()
 {
+    STATS_CALL();
+    
     try {
         buffer.clear();
         read_device("/proc/version",buffer);
@@ -521,6 +552,8 @@ const char* slb_info_kernel()
 
 const char* slb_info_cmdline()
 {
+    STATS_CALL();
+    
     try {
         buffer.clear();
         read_device("/proc/cmdline",buffer);
@@ -533,6 +566,8 @@ const char* slb_info_cmdline()
 
 uint64_t slb_info_total_memory()
 {
+    STATS_CALL();
+    
     struct sysinfo info;
     
     sysinfo(&info);
@@ -543,6 +578,8 @@ uint64_t slb_info_total_memory()
 
 uint64_t slb_info_available_memory()
 {
+    STATS_CALL();
+    
     struct sysinfo info;
     
     sysinfo(&info);
@@ -557,7 +594,7 @@ slb_tdp_info_t _get_TDP_intel()
     #define INTEL_RAPL_PATH "/sys/class/powercap/intel-rapl/intel-rapl:0/"
     slb_tdp_info_t tdp = {0};
 
-    if(filesystem::exists(INTEL_RAPL_PATH)){
+    if(device_exists(INTEL_RAPL_PATH)){
         string svalue;
         read_device(INTEL_RAPL_PATH"constraint_0_power_limit_uw", svalue);
 
@@ -637,8 +674,23 @@ static string _get_cpu_name(){
 
 slb_tdp_info_t slb_info_get_tdp_info()
 {
+    STATS_CALL();
+    
     slb_tdp_info_t tdp = {0,0,0, .type = SLB_TDP_TYPE_UNKNOWN};
     int32_t cpu_type;
+    uint32_t values[4];
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_TDP_INFO, 0, values, 4, &status)) {
+        if (status == 0) {
+            tdp.slow = values[0];
+            tdp.fast = values[1];
+            tdp.sustained = values[2];
+            tdp.type = values[3];
+        }
+        
+        return tdp;
+    }
     
     try {
         string name = _get_cpu_name();
@@ -665,6 +717,8 @@ slb_tdp_info_t slb_info_get_tdp_info()
 
 const char* slb_info_keyboard_device()
 {
+    STATS_CALL();
+    
     uint32_t platform = slb_info_get_platform();
     
     switch (platform) {
@@ -682,6 +736,8 @@ const char* slb_info_keyboard_device()
 
 const char* slb_info_module_device()
 {
+    STATS_CALL();
+    
     uint32_t platform = slb_info_get_platform();
     
     switch (platform) {
@@ -697,6 +753,7 @@ const char* slb_info_module_device()
 
 const char* slb_info_touchpad_device()
 {
+    STATS_CALL();
     
     uint32_t platform = slb_info_get_platform();
     
@@ -713,27 +770,44 @@ const char* slb_info_touchpad_device()
 
 uint32_t slb_info_get_ac_state(int ac,int* state)
 {
-    stringstream ss;
+    STATS_CALL();
     
-    ss<<"/sys/class/power_supply/AC"<<ac<<"/online";
+    char path[SLB_DEVICE_BUFFER_SIZE];
+    uint32_t value;
+    int status;
     
-    try {
-        string value;
+    /* daemon only tracks first AC device */
+    if (ac == 0 and _client_get(DAEMON_ATTR_AC_STATE, 0, &value, 1, &status)) {
+        if (status == 0) {
+            *state = value;
+        }
         
-        read_device(ss.str(),value);
-        *state = std::stoi(value);
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return ENOENT;
+    
+    snprintf(path, sizeof(path), "/sys/class/power_supply/AC%d/online", ac);
+    
+    if (read_device_u32(path,&value) != 0) {
+        STATS_RETURN(ENOENT);
     }
     
-    return 0;
+    *state = value;
+    
+    STATS_RETURN(0);
 }
 
 int slb_kbd_backlight_get(uint32_t model, uint32_t* color)
 {
+    STATS_CALL();
+    
     if (color == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
+    }
+    
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_KBD_BACKLIGHT, model, color, 1, &status)) {
+        STATS_RETURN(status);
     }
     
     if (model == 0) {
@@ -741,174 +815,167 @@ int slb_kbd_backlight_get(uint32_t model, uint32_t* color)
     }
     
     if (model == 0) {
-        return ENOENT;
+        STATS_RETURN(ENOENT);
     }
     
     if (model == SLB_MODEL_HERO_RPL_RTX or model == SLB_MODEL_CREATIVE_15_A8_RTX) {
-        try {
-            string svalue;
-            
-            read_device(SYSFS_LED_KBD"multi_intensity",svalue);
-            vector<string> pl = split(svalue,' ');
-            
-            uint32_t red,green,blue;
-            
-            red = std::stoi(pl[0],0,0);
-            green = std::stoi(pl[1],0,0);
-            blue = std::stoi(pl[2],0,0);
-            
-            uint32_t rgb = blue;
-            rgb = rgb | (green << 8);
-            rgb = rgb | (red << 16);
-            
-            *color = rgb;
-            
-            return 0;
-        }
-        catch(...) {
-            return EIO;
+        char svalue[SLB_DEVICE_BUFFER_SIZE];
+        uint32_t pl[3];
+        
+        if (read_device_buf(SYSFS_LED_KBD"multi_intensity",svalue,sizeof(svalue),DEVICE_SHADOW) != 0 or
+            parse_u32_list(svalue,pl,3,0) != 0) {
+            STATS_RETURN(EIO);
         }
+        
+        uint32_t rgb = pl[2];
+        rgb = rgb | (pl[1] << 8);
+        rgb = rgb | (pl[0] << 16);
+        
+        *color = rgb;
+        
+        STATS_RETURN(0);
     }
     
     if ((model & SLB_MODEL_ELEMENTAL) > 0 or model == SLB_MODEL_HERO_S_TGL_RTX) {
-        try {
-            string svalue;
-            uint32_t ival;
-            
-            read_device(SYSFS_CLEVO"color_left",svalue);
-            ival = std::stoi(svalue,0,16);
-            
-            *color = ival;
-            
-            return 0;
-        }
-        catch (...) {
-            return EIO;
+        if (read_device_u32(SYSFS_CLEVO"color_left",color,16,DEVICE_SHADOW) != 0) {
+            STATS_RETURN(EIO);
         }
-            
+        
+        STATS_RETURN(0);
     }
     
-    return ENOENT;
+    STATS_RETURN(ENOENT);
 }
 
 int slb_kbd_backlight_set(uint32_t model, uint32_t color)
 {
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_KBD_BACKLIGHT, model, color, 0, 0, &status)) {
+        STATS_RETURN(status);
+    }
+    
     if (model == 0) {
         model = slb_info_get_model();
     }
     
     if (model == 0) {
-        return ENOENT;
+        STATS_RETURN(ENOENT);
     }
     
     if (model == SLB_MODEL_HERO_RPL_RTX or model == SLB_MODEL_CREATIVE_15_A8_RTX) {
-        stringstream ss;
-        try {
-            uint32_t red = (color & 0x00ff0000) >> 16;
-            uint32_t green = (color & 0x0000ff00) >> 8;
-            uint32_t blue = (color & 0x000000ff);
-            ss<<red<<" "<<green<<" "<<blue;
-            write_device(SYSFS_LED_KBD"multi_intensity",ss.str());
-            
-            return 0;
-        }
-        catch(...) {
-            return EIO;
+        char svalue[SLB_DEVICE_BUFFER_SIZE];
+        uint32_t red = (color & 0x00ff0000) >> 16;
+        uint32_t green = (color & 0x0000ff00) >> 8;
+        uint32_t blue = (color & 0x000000ff);
+        int len = snprintf(svalue, sizeof(svalue), "%u %u %u", red, green, blue);
+        
+        if (write_device_buf(SYSFS_LED_KBD"multi_intensity",svalue,len,DEVICE_SHADOW) != 0) {
+            STATS_RETURN(EIO);
         }
+        
+        STATS_RETURN(0);
     }
     
     if ((model & SLB_MODEL_ELEMENTAL) > 0 or model == SLB_MODEL_HERO_S_TGL_RTX) {
-        try {
-            stringstream ss;
-            ss<<std::hex<<"0x"<<std::setfill('0')<<std::setw(6)<<color;
-            write_device(SYSFS_CLEVO"color_left",ss.str());
-            
-            return 0;
-        }
-        catch (...) {
-            return EIO;
+        char svalue[SLB_DEVICE_BUFFER_SIZE] = "0x";
+        int len = format_u32(svalue + 2, sizeof(svalue) - 2, color, 16, 6);
+        
+        if (write_device_buf(SYSFS_CLEVO"color_left",svalue,len + 2,DEVICE_SHADOW) != 0) {
+            STATS_RETURN(EIO);
         }
+        
+        STATS_RETURN(0);
     }
     
-    return ENOENT;
+    STATS_RETURN(ENOENT);
 }
 
 int slb_kbd_brightness_get(uint32_t model, uint32_t* brightness)
 {
-    string svalue;
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_KBD_BRIGHTNESS, model, brightness, 1, &status)) {
+        STATS_RETURN(status);
+    }
     
     if (model == 0) {
         model = slb_info_get_model();
     }
     
     if (model == 0) {
-        return ENOENT;
+        STATS_RETURN(ENOENT);
     }
     
     if (model == SLB_MODEL_HERO_RPL_RTX or model == SLB_MODEL_CREATIVE_15_A8_RTX) {
-        try {
-            read_device(SYSFS_LED_KBD"brightness",svalue);
-            *brightness = std::stoi(svalue,0,0);
-
-            return 0;
-        }
-        catch(...) {
-            return EIO;
+        if (read_device_u32(SYSFS_LED_KBD"brightness",brightness,0,DEVICE_SHADOW) != 0) {
+            STATS_RETURN(EIO);
         }
+
+        STATS_RETURN(0);
     }
     else {
         /* this is workaround for rgb-keyboard on clevo based models */
         *brightness = 0xff;
     }
     
-    return ENOENT;
+    STATS_RETURN(ENOENT);
 }
 
 int slb_kbd_brightness_set(uint32_t model, uint32_t brightness)
 {
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_KBD_BRIGHTNESS, model, brightness, 0, 0, &status)) {
+        STATS_RETURN(status);
+    }
+    
     if (model == 0) {
         model = slb_info_get_model();
     }
     
     if (model == 0) {
-        return ENOENT;
+        STATS_RETURN(ENOENT);
     }
     
     if (model == SLB_MODEL_HERO_RPL_RTX or model == SLB_MODEL_CREATIVE_15_A8_RTX) {
-        try {
-            stringstream ss;
-            ss<<brightness;
-            write_device(SYSFS_LED_KBD"brightness",ss.str());
-
-            return 0;
-        }
-        catch(...) {
-            return EIO;
+        if (write_device_u32(SYSFS_LED_KBD"brightness",brightness,DEVICE_SHADOW) != 0) {
+            STATS_RETURN(EIO);
         }
+
+        STATS_RETURN(0);
     }
     
-    return ENOENT;
+    STATS_RETURN(ENOENT);
 }
 
 int slb_kbd_brightness_max(uint32_t model, uint32_t* max)
 {
-    string svalue;
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_KBD_BRIGHTNESS_MAX, model, max, 1, &status)) {
+        STATS_RETURN(status);
+    }
     
     if (model == 0) {
         model = slb_info_get_model();
     }
     
     if (model == 0) {
-        return ENOENT;
+        STATS_RETURN(ENOENT);
     }
     
     if (model == SLB_MODEL_HERO_RPL_RTX or model == SLB_MODEL_CREATIVE_15_A8_RTX) {
-        try {
-            read_device(SYSFS_LED_KBD"max_brightness",svalue);
-            *max = std::stoi(svalue,0,0);
-        }
-        catch(...) {
-            return EIO;
+        if (read_device_u32(SYSFS_LED_KBD"max_brightness",max,0) != 0) {
+            STATS_RETURN(EIO);
         }
     }
     else {
@@ -916,28 +983,33 @@ int slb_kbd_brightness_max(uint32_t model, uint32_t* max)
         *max = 0xff;
     }
     
-    return ENOENT;
+    STATS_RETURN(ENOENT);
 }
 
 int slb_config_load(uint32_t model)
 {
+    STATS_CALL();
+    
     if (model == 0) {
         model = slb_info_get_model();
     }
     
     if (model == 0) {
-        return ENOENT;
+        STATS_RETURN(ENOENT);
     }
     
     // uint32_t platform = get_model_platform(model);
     bool module_loaded = slb_info_is_module_loaded();
 
+    /* firmware may have reset everything behind our back, ie: on resume */
+    shadow_invalidate(nullptr);
+
     Configuration conf;
     try {
         conf.load();
     }
     catch(...) {
-        return EIO;
+        STATS_RETURN(EIO);
     }
     
     if (module_loaded and model == SLB_MODEL_HERO_RPL_RTX) {
@@ -964,17 +1036,19 @@ int slb_config_load(uint32_t model)
         }
     }
 
-    return 0;
+    STATS_RETURN(0);
 }
 
 int slb_config_store(uint32_t model)
 {
+    STATS_CALL();
+    
     if (model == 0) {
         model = slb_info_get_model();
     }
     
     if (model == 0) {
-        return ENOENT;
+        STATS_RETURN(ENOENT);
     }
 
     uint32_t platform = get_model_platform(model);
@@ -1011,329 +1085,755 @@ int slb_config_store(uint32_t model)
             conf.set_u32("clevo.backlight",backlight);
         }
 
-        conf.store();
+        if (conf.store() != 0) {
+            STATS_RETURN(EIO);
+        }
     }
     catch(...) {
         cerr<<"Something went wrong"<<endl;
-        return EIO;
+        STATS_RETURN(EIO);
+    }
+    
+    STATS_RETURN(0);
+}
+
+int slb_profile_capture(slb_profile_t* profile)
+{
+    STATS_CALL();
+    
+    if (profile == nullptr) {
+        STATS_RETURN(EINVAL);
+    }
+    
+    memset(profile, 0, sizeof(*profile));
+    
+    uint32_t model = slb_info_get_model();
+    
+    if (model == 0) {
+        STATS_RETURN(ENOENT);
+    }
+    
+    if (slb_kbd_backlight_get(model,&profile->backlight) == 0) {
+        profile->fields |= SLB_PROFILE_BACKLIGHT;
+    }
+    
+    if (slb_kbd_brightness_get(model,&profile->brightness) == 0) {
+        profile->fields |= SLB_PROFILE_BRIGHTNESS;
+    }
+    
+    if (slb_info_get_platform() != SLB_PLATFORM_QC71 or slb_info_is_module_loaded() != SLB_MODULE_LOADED) {
+        STATS_RETURN(0);
+    }
+    
+    if (slb_qc71_profile_get(&profile->qc71_profile) == 0) {
+        profile->fields |= SLB_PROFILE_QC71_PROFILE;
+    }
+    
+    if (slb_qc71_silent_mode_get(&profile->silent_mode) == 0) {
+        profile->fields |= SLB_PROFILE_SILENT_MODE;
+    }
+    
+    if (slb_qc71_turbo_mode_get(&profile->turbo_mode) == 0) {
+        profile->fields |= SLB_PROFILE_TURBO_MODE;
+    }
+    
+    if (slb_qc71_manual_control_get(&profile->manual_control) == 0) {
+        profile->fields |= SLB_PROFILE_MANUAL_CONTROL;
+    }
+    
+    if (slb_qc71_custom_tdp_get(&profile->tdp_pl1,&profile->tdp_pl2,&profile->tdp_pl4) == 0) {
+        profile->fields |= SLB_PROFILE_CUSTOM_TDP;
+    }
+    
+    if (slb_qc71_fn_lock_get(&profile->fn_lock) == 0) {
+        profile->fields |= SLB_PROFILE_FN_LOCK;
+    }
+    
+    if (slb_qc71_super_lock_get(&profile->super_lock) == 0) {
+        profile->fields |= SLB_PROFILE_SUPER_LOCK;
+    }
+    
+    STATS_RETURN(0);
+}
+
+static bool _profile_name_valid(const char* name)
+{
+    if (name == nullptr) {
+        return false;
+    }
+    
+    size_t len = strlen(name);
+    
+    if (len == 0 or len >= SLB_PROFILE_MAX_NAME) {
+        return false;
+    }
+    
+    /* dots split keys and colons split text export lines */
+    return strpbrk(name, ".:\n") == nullptr;
+}
+
+int slb_profile_get(const char* name, slb_profile_t* profile)
+{
+    STATS_CALL();
+    
+    if (!_profile_name_valid(name) or profile == nullptr) {
+        STATS_RETURN(EINVAL);
+    }
+    
+    Configuration conf;
+    
+    try {
+        conf.load();
+    }
+    catch(...) {
+        STATS_RETURN(EIO);
+    }
+    
+    if (!conf.find_profile(name,*profile)) {
+        STATS_RETURN(ENOENT);
+    }
+    
+    STATS_RETURN(0);
+}
+
+int slb_profile_set(const char* name, const slb_profile_t* profile)
+{
+    STATS_CALL();
+    
+    if (!_profile_name_valid(name) or profile == nullptr) {
+        STATS_RETURN(EINVAL);
+    }
+    
+    Configuration conf;
+    
+    try {
+        conf.load();
+        conf.set_profile(name,*profile);
+        
+        if (conf.store() != 0) {
+            STATS_RETURN(EIO);
+        }
+    }
+    catch(...) {
+        STATS_RETURN(EIO);
     }
     
-    return 0;
+    STATS_RETURN(0);
+}
+
+int slb_profile_restore(const slb_profile_t* profile)
+{
+    STATS_CALL();
+    
+    if (profile == nullptr) {
+        STATS_RETURN(EINVAL);
+    }
+    
+    const slb_profile_t& target = *profile;
+    slb_profile_t current;
+    int status = slb_profile_capture(&current);
+    
+    if (status != 0) {
+        STATS_RETURN(status);
+    }
+    
+    int result = 0;
+    
+    #define PROFILE_DIFFERS(field, member) ((target.fields & current.fields & (field)) and target.member != current.member)
+    #define PROFILE_RESULT(call) do { int call_status = (call); if (result == 0) { result = call_status; } } while(0)
+    
+    /* performance profile goes first, firmware may adjust other attributes when it changes */
+    if (PROFILE_DIFFERS(SLB_PROFILE_QC71_PROFILE, qc71_profile)) {
+        PROFILE_RESULT(slb_qc71_profile_set(target.qc71_profile));
+        slb_profile_capture(&current);
+    }
+    
+    if (PROFILE_DIFFERS(SLB_PROFILE_SILENT_MODE, silent_mode)) {
+        PROFILE_RESULT(slb_qc71_silent_mode_set(target.silent_mode));
+    }
+    
+    if (PROFILE_DIFFERS(SLB_PROFILE_TURBO_MODE, turbo_mode)) {
+        PROFILE_RESULT(slb_qc71_turbo_mode_set(target.turbo_mode));
+    }
+    
+    if (PROFILE_DIFFERS(SLB_PROFILE_MANUAL_CONTROL, manual_control)) {
+        PROFILE_RESULT(slb_qc71_manual_control_set(target.manual_control));
+    }
+    
+    /*
+      firmware ignores custom tdp unless manual control is on, and resets
+      it on resume, so it is only written for profiles that had it on
+    */
+    bool manual = (target.fields & SLB_PROFILE_MANUAL_CONTROL) and target.manual_control != 0;
+    
+    if (manual and (PROFILE_DIFFERS(SLB_PROFILE_CUSTOM_TDP, tdp_pl1) or
+        PROFILE_DIFFERS(SLB_PROFILE_CUSTOM_TDP, tdp_pl2) or
+        PROFILE_DIFFERS(SLB_PROFILE_CUSTOM_TDP, tdp_pl4))) {
+        PROFILE_RESULT(slb_qc71_custom_tdp_set(target.tdp_pl1,target.tdp_pl2,target.tdp_pl4));
+    }
+    
+    if (PROFILE_DIFFERS(SLB_PROFILE_FN_LOCK, fn_lock)) {
+        PROFILE_RESULT(slb_qc71_fn_lock_set(target.fn_lock));
+    }
+    
+    if (PROFILE_DIFFERS(SLB_PROFILE_SUPER_LOCK, super_lock)) {
+        PROFILE_RESULT(slb_qc71_super_lock_set(target.super_lock));
+    }
+    
+    if (PROFILE_DIFFERS(SLB_PROFILE_BACKLIGHT, backlight)) {
+        PROFILE_RESULT(slb_kbd_backlight_set(0,target.backlight));
+    }
+    
+    if (PROFILE_DIFFERS(SLB_PROFILE_BRIGHTNESS, brightness)) {
+        PROFILE_RESULT(slb_kbd_brightness_set(0,target.brightness));
+    }
+    
+    #undef PROFILE_DIFFERS
+    #undef PROFILE_RESULT
+    
+    STATS_RETURN(result);
+}
+
+int slb_profile_apply(const char* name)
+{
+    STATS_CALL();
+    
+    slb_profile_t target;
+    int status = slb_profile_get(name,&target);
+    
+    if (status != 0) {
+        STATS_RETURN(status);
+    }
+    
+    STATS_RETURN(slb_profile_restore(&target));
 }
 
 int slb_qc71_manual_control_get(uint32_t* value)
 {
+    STATS_CALL();
+    
     if (value == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
     
-    try {
-        string svalue;
-        read_device(SYSFS_QC71"manual_control",svalue);
-        *value = std::stoi(svalue,0,10);
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_QC71_MANUAL_CONTROL, 0, value, 1, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (read_device_u32(SYSFS_QC71"manual_control",value,10,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_manual_control_set(uint32_t value)
 {
-    try {
-        stringstream ss;
-        ss<<value;
-        write_device(SYSFS_QC71"manual_control",ss.str());
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_QC71_MANUAL_CONTROL, 0, value, 0, 0, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (write_device_u32(SYSFS_QC71"manual_control",value,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_fn_lock_get(uint32_t* value)
 {
+    STATS_CALL();
+    
     if (value == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
     
-    try {
-        string svalue;
-        read_device(SYSFS_QC71"fn_lock",svalue);
-        *value = std::stoi(svalue,0,10);
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_QC71_FN_LOCK, 0, value, 1, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (read_device_u32(SYSFS_QC71"fn_lock",value,10,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_fn_lock_set(uint32_t value)
 {
-    try {
-        stringstream ss;
-        ss<<value;
-        write_device(SYSFS_QC71"fn_lock",ss.str());
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_QC71_FN_LOCK, 0, value, 0, 0, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (write_device_u32(SYSFS_QC71"fn_lock",value,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_super_lock_get(uint32_t* value)
 {
+    STATS_CALL();
+    
     if (value == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
     
-    try {
-        string svalue;
-        read_device(SYSFS_QC71"super_key_lock",svalue);
-        *value = std::stoi(svalue,0,10);
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_QC71_SUPER_LOCK, 0, value, 1, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (read_device_u32(SYSFS_QC71"super_key_lock",value,10,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_super_lock_set(uint32_t value)
 {
-    try {
-        stringstream ss;
-        ss<<value;
-        write_device(SYSFS_QC71"super_key_lock",ss.str());
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_QC71_SUPER_LOCK, 0, value, 0, 0, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (write_device_u32(SYSFS_QC71"super_key_lock",value,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
 
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
-#define QC71_HWMON SYSFS_QC71"hwmon/"
-
-static int _slb_qc71_fan_get_common(string fan, uint32_t* value){
-    string spath;
-
-    find_file(QC71_HWMON, fan, spath);
-
+static int _slb_fan_get_common(const char* chip, int32_t fan, uint32_t attr, uint32_t* value){
     if (value == nullptr ) {
         return EINVAL;
     }
     
-    try {
-        if(spath.size() == 0){
-            *value = -1;
-        }
-        else{
-            string svalue;
-
-            read_device(spath+fan,svalue);
-            *value = std::stoi(svalue,0,10);
-        }
+    int status;
+    
+    if (_client_get(attr, 0, value, 1, &status)) {
+        return status;
     }
-    catch (...) {
+    
+    hwmon_sensor* sensor = hwmon_find_sensor(chip, HWMON_FAN, fan);
+    int64_t rpm;
+    
+    if (sensor == nullptr) {
+        *value = -1;
+    }
+    else if (hwmon_read(sensor, &rpm) != 0) {
         return EIO;
     }
+    else {
+        *value = rpm;
+    }
     
     return SLB_SUCCESS;
 }
 
 int slb_qc71_primary_fan_get(uint32_t* value){
-    return _slb_qc71_fan_get_common("fan1_input", value);
+    STATS_CALL();
+    
+    STATS_RETURN(_slb_fan_get_common(MODULE_QC71, 1, DAEMON_ATTR_QC71_PRIMARY_FAN, value));
 }
 
 int slb_qc71_secondary_fan_get(uint32_t* value){
-    return _slb_qc71_fan_get_common("fan2_input", value);
+    STATS_CALL();
+    
+    STATS_RETURN(_slb_fan_get_common(MODULE_QC71, 2, DAEMON_ATTR_QC71_SECONDARY_FAN, value));
+}
 
+int slb_clevo_primary_fan_get(uint32_t* value){
+    STATS_CALL();
+    
+    STATS_RETURN(_slb_fan_get_common(MODULE_CLEVO, 1, DAEMON_ATTR_CLEVO_PRIMARY_FAN, value));
+}
+
+int slb_clevo_secondary_fan_get(uint32_t* value){
+    STATS_CALL();
+    
+    STATS_RETURN(_slb_fan_get_common(MODULE_CLEVO, 2, DAEMON_ATTR_CLEVO_SECONDARY_FAN, value));
 }
 
 #define SYS_PWS "/sys/class/power_supply/"
 
 int slb_battery_info_get(slb_sys_battery_info* info){
+    STATS_CALL();
+    
     if(info == nullptr){
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
 
-    if(!filesystem::exists(SYS_PWS"/BAT0/")){
-        return ENOENT;
-    }
+    char svalue[SLB_DEVICE_BUFFER_SIZE];
+    uint32_t capacity;
+    uint32_t charge;
+    int status;
+    uint32_t values[3];
     
-    try {
-        string svalue;
+    if (_client_get(DAEMON_ATTR_BATTERY, 0, values, 3, &status)) {
+        if (status == 0) {
+            info->capacity = values[0];
+            info->charge = values[1];
+            info->status = values[2];
+        }
+        
+        STATS_RETURN(status);
+    }
 
-        read_device(SYS_PWS"/BAT0/capacity",svalue);
-        info->capacity = std::stoi(svalue,0,10);
+    /* a missing capacity means there is no battery at all */
+    status = read_device_u32(SYS_PWS"/BAT0/capacity",&capacity);
 
-        read_device(SYS_PWS"/BAT0/charge_now", svalue);
-        info->charge = (std::stoi(svalue,0,10) / 100);
-        
-        read_device(SYS_PWS"/BAT0/status",svalue);
+    if (status == ENOENT) {
+        STATS_RETURN(ENOENT);
+    }
 
-        if(strcmp(svalue.c_str(), "Charging") == 0){
-            info->status = 1;
-        }
-        else if(strcmp(svalue.c_str(), "Discharging") == 0){
-            info->status = 2;
-        }
-        else if(strcmp(svalue.c_str(), "Not charging") == 0){
-            info->status = 3;
-        }
-        else if(strcmp(svalue.c_str(), "Full") == 0){
-            info->status = 4;
-        }
-        else {
-            info->status = 0;
-        }
+    if (status != 0 or
+        read_device_u32(SYS_PWS"/BAT0/charge_now",&charge) != 0 or
+        read_device_buf(SYS_PWS"/BAT0/status",svalue,sizeof(svalue)) != 0) {
+        STATS_RETURN(EIO);
     }
-    catch (...) {
-        return EIO;
+
+    info->capacity = capacity;
+    info->charge = charge / 100;
+
+    if(strcmp(svalue, "Charging") == 0){
+        info->status = 1;
+    }
+    else if(strcmp(svalue, "Discharging") == 0){
+        info->status = 2;
+    }
+    else if(strcmp(svalue, "Not charging") == 0){
+        info->status = 3;
+    }
+    else if(strcmp(svalue, "Full") == 0){
+        info->status = 4;
+    }
+    else {
+        info->status = 0;
     }
 
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_silent_mode_get(uint32_t* value)
 {
+    STATS_CALL();
+    
     if (value == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
     
-    try {
-        string svalue;
-        read_device(SYSFS_QC71"silent_mode",svalue);
-        *value = std::stoi(svalue,0,10);
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_QC71_SILENT_MODE, 0, value, 1, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (read_device_u32(SYSFS_QC71"silent_mode",value,10,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_silent_mode_set(uint32_t value)
 {
-    try {
-        stringstream ss;
-        ss<<value;
-        write_device(SYSFS_QC71"silent_mode",ss.str());
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_QC71_SILENT_MODE, 0, value, 0, 0, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (write_device_u32(SYSFS_QC71"silent_mode",value,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
 
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_turbo_mode_get(uint32_t* value)
 {
+    STATS_CALL();
+    
     if (value == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
     
-    try {
-        string svalue;
-        read_device(SYSFS_QC71"turbo_mode",svalue);
-        *value = std::stoi(svalue,0,10);
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_QC71_TURBO_MODE, 0, value, 1, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (read_device_u32(SYSFS_QC71"turbo_mode",value,10,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_turbo_mode_set(uint32_t value)
 {
-    try {
-        stringstream ss;
-        ss<<value;
-        write_device(SYSFS_QC71"turbo_mode",ss.str());
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_QC71_TURBO_MODE, 0, value, 0, 0, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (write_device_u32(SYSFS_QC71"turbo_mode",value,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
 
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_profile_get(uint32_t* value)
 {
+    STATS_CALL();
+    
     if (value == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
     
-    try {
-        string svalue;
-        read_device(SYSFS_QC71"performance_mode",svalue);
-        *value = std::stoi(svalue,0,10);
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_QC71_PROFILE, 0, value, 1, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (read_device_u32(SYSFS_QC71"performance_mode",value,10,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_profile_set(uint32_t value)
 {
-    try {
-        stringstream ss;
-        ss<<value;
-        write_device(SYSFS_QC71"performance_mode",ss.str());
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_QC71_PROFILE, 0, value, 0, 0, &status)) {
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    if (write_device_u32(SYSFS_QC71"performance_mode",value,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
 
-    return SLB_SUCCESS;
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_custom_tdp_get(uint32_t* pl1, uint32_t* pl2, uint32_t* pl4)
 {
+    STATS_CALL();
+    
     if (pl1 == nullptr or pl2 == nullptr or pl4 == nullptr) {
-        return EINVAL;
+        STATS_RETURN(EINVAL);
     }
     
-    try {
-        string svalue;
-        read_device(SYSFS_QC71"custom_tdp",svalue);
-        vector<string> pl = split(svalue,' ');
+    uint32_t pl[3];
+    int status;
+    
+    if (_client_get(DAEMON_ATTR_QC71_CUSTOM_TDP, 0, pl, 3, &status)) {
+        if (status == 0) {
+            *pl1 = pl[0];
+            *pl2 = pl[1];
+            *pl4 = pl[2];
+        }
         
-        *pl1 = std::stoi(pl[0],0,0);
-        *pl2 = std::stoi(pl[1],0,0);
-        *pl4 = std::stoi(pl[2],0,0);
+        STATS_RETURN(status);
     }
-    catch (...) {
-        return EIO;
+    
+    char svalue[SLB_DEVICE_BUFFER_SIZE];
+    
+    if (read_device_buf(SYSFS_QC71"custom_tdp",svalue,sizeof(svalue),DEVICE_SHADOW) != 0 or
+        parse_u32_list(svalue,pl,3,0) != 0) {
+        STATS_RETURN(EIO);
     }
     
-    return SLB_SUCCESS;
+    *pl1 = pl[0];
+    *pl2 = pl[1];
+    *pl4 = pl[2];
+    
+    STATS_RETURN(SLB_SUCCESS);
 }
 
 int slb_qc71_custom_tdp_set(uint32_t pl1, uint32_t pl2, uint32_t pl4)
 {
+    STATS_CALL();
+    
+    int status;
+    
+    if (_client_set(DAEMON_ATTR_QC71_CUSTOM_TDP, 0, pl1, pl2, pl4, &status)) {
+        STATS_RETURN(status);
+    }
+    
     const uint32_t max_tdp = 80;
     
     pl1 = std::min(pl1,max_tdp);
     pl2 = std::min(pl2,max_tdp);
     pl4 = std::min(pl4,max_tdp);
     
-    try {
-        stringstream ss;
-        ss<<pl1<<" "<<pl2<<" "<<pl4;
-        write_device(SYSFS_QC71"custom_tdp",ss.str());
+    char svalue[SLB_DEVICE_BUFFER_SIZE];
+    int len = snprintf(svalue, sizeof(svalue), "%u %u %u", pl1, pl2, pl4);
+    
+    if (write_device_buf(SYSFS_QC71"custom_tdp",svalue,len,DEVICE_SHADOW) != 0) {
+        STATS_RETURN(EIO);
     }
-    catch (...) {
-        return EIO;
+
+    STATS_RETURN(SLB_SUCCESS);
+}
+
+int slb_shadow_set_ttl(uint32_t ms)
+{
+    STATS_CALL();
+    
+    shadow_set_ttl(ms);
+    
+    STATS_RETURN(SLB_SUCCESS);
+}
+
+int slb_shadow_force(int force)
+{
+    STATS_CALL();
+    
+    shadow_set_force(force != 0);
+    
+    STATS_RETURN(SLB_SUCCESS);
+}
+
+int slb_shadow_invalidate()
+{
+    STATS_CALL();
+    
+    shadow_invalidate(nullptr);
+    
+    STATS_RETURN(SLB_SUCCESS);
+}
+
+/* drops everything read from hardware, or from a previous root or trace */
+static void _drop_caches()
+{
+    info_cached = false;
+    hwmon_reset();
+    shadow_invalidate(nullptr);
+    module_cache_invalidate();
+    slb_telemetry_close();
+}
+
+int slb_root_set(const char* root)
+{
+    STATS_CALL();
+    
+    root_set(root);
+    _drop_caches();
+    
+    STATS_RETURN(SLB_SUCCESS);
+}
+
+int slb_trace_start(int mode, const char* path)
+{
+    STATS_CALL();
+    
+    if (mode != SLB_TRACE_OFF and (path == nullptr or path[0] == 0)) {
+        STATS_RETURN(EINVAL);
     }
 
+    if (mode < SLB_TRACE_OFF or mode > SLB_TRACE_REPLAY) {
+        STATS_RETURN(EINVAL);
+    }
+
+    int status = trace_start(mode, path);
+
+    _drop_caches();
+
+    STATS_RETURN(status);
+}
+
+int slb_trace_stop()
+{
+    STATS_CALL();
+    
+    trace_stop();
+    _drop_caches();
+
+    STATS_RETURN(SLB_SUCCESS);
+}
+
+int slb_stats_enable(int enable)
+{
+    stats_enable(enable != 0);
+    
     return SLB_SUCCESS;
 }
+
+int slb_stats_get(slb_stats_t* stats, int* count)
+{
+    if (count == nullptr or (stats != nullptr and *count < 0)) {
+        return EINVAL;
+    }
+    
+    *count = stats_snapshot(stats, *count);
+    
+    return SLB_SUCCESS;
+}
+
+int slb_stats_reset()
+{
+    stats_reset();
+    
+    return SLB_SUCCESS;
+}
+
+int slb_timeline_start(const char* path)
+{
+    if (path == nullptr or path[0] == 0) {
+        return EINVAL;
+    }
+    
+    return timeline_start(path);
+}
+
+int slb_timeline_stop()
+{
+    timeline_stop();
+    
+    return SLB_SUCCESS;
+}
+
+int slb_shadow_stats_get(slb_shadow_stats_t* stats)
+{
+    STATS_CALL();
+    
+    if (stats == nullptr) {
+        STATS_RETURN(EINVAL);
+    }
+    
+    shadow_stats(&stats->writes, &stats->skipped);
+    
+    STATS_RETURN(SLB_SUCCESS);
+}
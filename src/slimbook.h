@@ -18,6 +18,9 @@ along with this program; if not, write to the Free Software Foundation,
 Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
+#ifndef SLB_SLIMBOOK_H
+#define SLB_SLIMBOOK_H
+
 #include <stdint.h>
 #include <stddef.h>
 
@@ -184,6 +187,94 @@ typedef struct {
     uint8_t type : 2;
 } slb_tdp_info_t;
 
+#define SLB_PROFILE_MAX_NAME            32
+
+#define SLB_PROFILE_BACKLIGHT           0x0001
+#define SLB_PROFILE_BRIGHTNESS          0x0002
+#define SLB_PROFILE_QC71_PROFILE        0x0004
+#define SLB_PROFILE_SILENT_MODE         0x0008
+#define SLB_PROFILE_TURBO_MODE          0x0010
+#define SLB_PROFILE_CUSTOM_TDP          0x0020
+#define SLB_PROFILE_FN_LOCK             0x0040
+#define SLB_PROFILE_SUPER_LOCK          0x0080
+#define SLB_PROFILE_MANUAL_CONTROL      0x0100
+
+typedef struct {
+    /* which of the fields below are set, see SLB_PROFILE_* */
+    uint32_t fields;
+
+    uint32_t backlight;
+    uint32_t brightness;
+    uint32_t qc71_profile;
+    uint32_t silent_mode;
+    uint32_t turbo_mode;
+    uint32_t tdp_pl1;
+    uint32_t tdp_pl2;
+    uint32_t tdp_pl4;
+    uint32_t fn_lock;
+    uint32_t super_lock;
+    /* custom TDP is only restored when this was on */
+    uint32_t manual_control;
+} slb_profile_t;
+
+typedef struct {
+    /* writes that reached the driver */
+    uint64_t writes;
+    /* writes dropped because the attribute already held that value */
+    uint64_t skipped;
+} slb_shadow_stats_t;
+
+/* latency histogram buckets, bucket n counts timed calls that took [2^(n-1), 2^n) ns */
+#define SLB_STATS_BUCKETS   32
+#define SLB_STATS_NAME_SIZE 48
+
+typedef struct {
+    char name[SLB_STATS_NAME_SIZE];
+    uint64_t calls;
+    /* sampled calls whose latency was measured, total_ns and buckets only cover these */
+    uint64_t timed;
+    /* calls returning an errno status */
+    uint64_t errors;
+    /* syscalls done on hardware and daemon I/O */
+    uint64_t syscalls;
+    /* writes that reached a platform driver attribute */
+    uint64_t ec_writes;
+    uint64_t total_ns;
+    uint64_t buckets[SLB_STATS_BUCKETS];
+} slb_stats_t;
+
+#define SLB_TELEMETRY_QC71_PRIMARY_FAN      0x0001
+#define SLB_TELEMETRY_QC71_SECONDARY_FAN    0x0002
+#define SLB_TELEMETRY_CLEVO_PRIMARY_FAN     0x0004
+#define SLB_TELEMETRY_CLEVO_SECONDARY_FAN   0x0008
+#define SLB_TELEMETRY_BATTERY               0x0010
+#define SLB_TELEMETRY_AC_STATE              0x0020
+#define SLB_TELEMETRY_TDP                   0x0040
+
+typedef struct {
+    /* increases on every update */
+    uint64_t generation;
+    /* CLOCK_MONOTONIC nanoseconds of last update */
+    uint64_t timestamp;
+    /* SLB_TELEMETRY_* bits of fields that were read successfully */
+    uint32_t valid;
+
+    uint32_t qc71_primary_fan;
+    uint32_t qc71_secondary_fan;
+    uint32_t clevo_primary_fan;
+    uint32_t clevo_secondary_fan;
+
+    uint32_t battery_capacity;
+    uint32_t battery_charge;
+    uint32_t battery_status;
+    uint32_t ac_state;
+
+    uint32_t tdp_slow;
+    uint32_t tdp_fast;
+    uint32_t tdp_sustained;
+    uint32_t tdp_type;
+} slb_telemetry_t;
+
 /* Retrieves DMI info and cache it. No need to call this function */
 extern "C" int32_t slb_info_retrieve();
 
@@ -226,6 +317,9 @@ extern "C" uint32_t slb_info_find_platform(uint32_t model);
 /* Checks if platform module is loaded */
 extern "C" uint32_t slb_info_is_module_loaded();
 
+/* Listens for module uevents so slb_info_is_module_loaded answers from cache. Returns 0 or errno */
+extern "C" int slb_info_module_listener_start();
+
 /* Gets system uptime in seconds */
 extern "C" int64_t slb_info_uptime();
 
@@ -284,6 +378,24 @@ extern "C" int slb_config_load(uint32_t model);
 /* Stores configuration from driver to disk */
 extern "C" int slb_config_store(uint32_t model);
 
+/* Reads current hardware state into a profile, only fields that apply to this model are set */
+extern "C" int slb_profile_capture(slb_profile_t* profile);
+
+/* Gets a named profile from disk */
+extern "C" int slb_profile_get(const char* name, slb_profile_t* profile);
+
+/* Stores a named profile to disk */
+extern "C" int slb_profile_set(const char* name, const slb_profile_t* profile);
+
+/*
+  Applies a profile, only fields that differ from current hardware state are
+  written. Custom TDP is only written when profile has manual control on
+*/
+extern "C" int slb_profile_restore(const slb_profile_t* profile);
+
+/* Applies a named profile, only fields that differ from current hardware state are written */
+extern "C" int slb_profile_apply(const char* name);
+
 /* Gets Manual control status */
 extern "C" int slb_qc71_manual_control_get(uint32_t* value);
 
@@ -308,6 +420,12 @@ extern "C" int slb_qc71_primary_fan_get(uint32_t* value);
 /* Gets RPM for secondary fan */
 extern "C" int slb_qc71_secondary_fan_get(uint32_t* value);
 
+/* Gets RPM for primary fan */
+extern "C" int slb_clevo_primary_fan_get(uint32_t* value);
+
+/* Gets RPM for secondary fan */
+extern "C" int slb_clevo_secondary_fan_get(uint32_t* value);
+
 /* Gets battery info */
 extern "C" int slb_battery_info_get(slb_sys_battery_info* info);
 
@@ -335,3 +453,88 @@ extern "C" int slb_qc71_custom_tdp_get(uint32_t* pl1, uint32_t* pl2, uint32_t* p
 /* Sets custom TDP */
 extern "C" int slb_qc71_custom_tdp_set(uint32_t pl1, uint32_t pl2, uint32_t pl4);
 
+/*
+  Sets how long, in milliseconds, a shadowed attribute value is trusted.
+  It is also dropped on resume and on module or platform device uevents,
+  when slimbookd listens to them. 0 disables write skipping
+*/
+extern "C" int slb_shadow_set_ttl(uint32_t ms);
+
+/* Forces setters on calling thread to write even if value did not change, through slimbookd too */
+extern "C" int slb_shadow_force(int force);
+
+/* Drops all shadowed attribute values, ie: after resume */
+extern "C" int slb_shadow_invalidate();
+
+/* Gets shadow write counters */
+extern "C" int slb_shadow_stats_get(slb_shadow_stats_t* stats);
+
+/*
+  Gets a consistent snapshot of telemetry published by slimbookd. Only the
+  first call opens the segment, later ones are plain memory loads, until
+  slimbookd is restarted. Safe to call from any number of threads.
+  Returns ENOENT when slimbookd is not publishing.
+*/
+extern "C" int slb_telemetry_read(slb_telemetry_t* telemetry);
+
+/*
+  Unmaps telemetry segment. Must not race with slb_telemetry_read, no
+  other thread may be reading telemetry while it runs.
+*/
+extern "C" int slb_telemetry_close();
+
+/*
+  Resolves every system path under root, as a fixture tree, instead of /.
+  Also read from SLB_ROOT environment variable on first use, except for
+  setuid callers. Cached model, sensors and shadow values are dropped.
+  Call it before any other thread uses the library, nullptr or "" goes
+  back to the real system.
+*/
+extern "C" int slb_root_set(const char* root);
+
+#define SLB_TRACE_OFF       0
+#define SLB_TRACE_RECORD    1
+#define SLB_TRACE_REPLAY    2
+
+/*
+  Records every hardware access (sysfs, pci config space, /dev/mem and
+  cpuid) with its payload and duration to path, or serves them back from a
+  previous recording with same timings. Also started from SLB_TRACE_RECORD
+  or SLB_TRACE_REPLAY environment variables, except for setuid callers.
+  Cached model, sensors and shadow values are dropped.
+*/
+extern "C" int slb_trace_start(int mode, const char* path);
+
+/* Flushes and closes current trace, going back to hardware */
+extern "C" int slb_trace_stop();
+
+/*
+  Turns counting of public calls on, or off when enable is 0. It is on by
+  default, unless SLB_STATS environment variable is set to 0, and only a
+  random sample of calls read the clock to keep it cheap.
+*/
+extern "C" int slb_stats_enable(int enable);
+
+/*
+  Gets counters of every public call made while counting was on since load
+  or last reset, from all threads. Fills up to count entries and sets count
+  to the number of calls tracked, stats can be nullptr to just get that number.
+*/
+extern "C" int slb_stats_get(slb_stats_t* stats, int* count);
+
+/* Starts counting again from zero */
+extern "C" int slb_stats_reset();
+
+/*
+  Writes a span for every public call and every sysfs, pci, SMU, SMBIOS
+  and cpuid access below it to path, as Chrome trace event JSON that
+  Perfetto or chrome://tracing can open. Spans are buffered per thread and
+  written out when the timeline stops, at exit or when a thread ends. Also
+  started from SLB_TIMELINE environment variable, except for setuid callers.
+*/
+extern "C" int slb_timeline_start(const char* path);
+
+/* Writes out pending spans and closes the timeline */
+extern "C" int slb_timeline_stop();
+
+#endif
@@ -20,13 +20,25 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "slimbook.h"
 #include "common.h"
+#include "configuration.h"
+#include "daemon.h"
 #include "amdsmu.h"
 
 #include "pci.h"
+#include "archive.h"
+#include "collectors.h"
+#include "redact.h"
+#include "monitor.h"
+#include "bench.h"
+#include "fixture.h"
+
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <mntent.h>
 #include <unistd.h>
 
@@ -34,18 +46,32 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <iomanip>
 #include <string>
 #include <vector>
+#include <set>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <filesystem>
 #include <cstdlib>
 #include <ctime>
 #include <sstream>
+#include <stdexcept>
 #include <regex>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <algorithm>
 #include <string.h>
 
 #define SLB_REPORT_PRIVATE "SLB_REPORT_PRIVATE"
 #define SYS_AMDGPU "/sys/class/drm/card%d/device/"
 
+#define REPORT_D "/usr/libexec/slimbook/report.d/"
+#define REPORT_JOBS 4
+#define REPORT_TIMEOUT_MS 30000
+#define REPORT_BUFFER_SIZE (64 * 1024)
+
 using namespace std;
 
 string generate_id()
@@ -60,42 +86,351 @@ string generate_id()
     return ss.str();
 }
 
-static int run_command(string file, vector<string>args)
+struct collector_t
+{
+    string name;
+    pid_t pid;
+    /* read end of collector stdout, -1 once drained */
+    int fd;
+    collector_output_t output;
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::duration elapsed;
+    int status;
+    bool exited;
+    bool timed_out;
+    /* set for built in collectors, status is then its return value */
+    collector_proc collect;
+    /* inputs hash, when output may be cached */
+    bool cacheable;
+    uint64_t key;
+    /* output came from cache, nothing was run */
+    bool cached;
+};
+
+static pid_t spawn_collector(string file, int* fd)
 {
+    int pipefd[2];
+    
+    if (pipe2(pipefd, O_CLOEXEC) < 0) {
+        return -1;
+    }
+    
     pid_t pid = fork();
     
     if (pid == 0) {
-        char* argv[10];
-        int n = 1;
-
-        argv[0] = (char*)file.c_str();
-
-        while(n < (int)args.size() +1){
-            argv[n] = (char*)args[n -1].c_str();n++;
-        }
-
-        argv[n] = nullptr;
+        /* own process group, so a timeout takes its children down too */
+        setpgid(0, 0);
+        
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, nullptr);
+        
+        dup2(pipefd[1], STDOUT_FILENO);
+        
         //switching to root UID
         setuid(0);
-        int status = execvp(argv[0], argv);
+        
+        /* collectors write to $1, point it at the pipe */
+        execl(file.c_str(), file.c_str(), "/dev/stdout", nullptr);
+        _exit(127);
+    }
+    
+    close(pipefd[1]);
+    
+    if (pid < 0) {
+        close(pipefd[0]);
+        return -1;
+    }
+    
+    /* same as above, whoever runs first wins */
+    setpgid(pid, pid);
+    *fd = pipefd[0];
+    
+    return pid;
+}
 
-        if (status < 0) {
-            exit(status);
+static void finish_collector(collector_t& collector, archive_t* archive, string prefix, time_t mtime, const set<string>& scripts, const redactor_t* redactor)
+{
+    const char* mark = "✗";
+    int code = -1;
+    
+    if (collector.cached) {
+        code = 0;
+    }
+    else if (collector.collect) {
+        code = collector.status;
+    }
+    else if (!collector.timed_out and WIFEXITED(collector.status)) {
+        code = WEXITSTATUS(collector.status);
+    }
+    
+    if (code == 0) {
+        mark = "✓";
+    }
+    else if (code == COLLECTOR_NOT_APPLICABLE) {
+        mark = "⚑";
+    }
+    
+    clog<<" "<<collector.name<<" "<<mark<<(collector.cached ? " (cached)" : "")<<endl;
+    
+    if (code == 0 and collector.cacheable and !collector.cached) {
+        collector_cache_put(collector.name, collector.key, collector.output);
+    }
+    
+    /* flagged collectors do not apply to this system, nothing to store */
+    if (code != COLLECTOR_NOT_APPLICABLE) {
+        /* cache keeps raw output, so a later full report can reuse it */
+        if (redactor) {
+            redact(redactor, collector.output.text);
+            
+            for (auto& entry : collector.output.extra) {
+                redact(redactor, entry.second);
+            }
         }
         
-        //this may not happen
-        return 0;
+        archive_add(archive, prefix + collector.name + ".txt", std::move(collector.output.text), mtime);
+        
+        for (auto& entry : collector.output.extra) {
+            /* a script writing the same entry wins, as it does for whole collectors */
+            if (scripts.count(entry.first.substr(0, entry.first.rfind('.'))) == 0) {
+                archive_add(archive, prefix + entry.first, std::move(entry.second), mtime);
+            }
+        }
     }
-    else {
-        int status;
-        int ret = waitpid(pid,&status,0);
+    
+    collector.output = {};
+}
+
+/*
+  Runs every collector in path, at most REPORT_JOBS at once, and streams
+  their output into archive as each one finishes. Collectors running longer
+  than REPORT_TIMEOUT_MS get their process group killed. Built in collectors
+  run in process, on a thread of their own, unless a script overrides them.
+  Collectors whose inputs did not change since last report are not run
+  at all, their cached output is used instead, unless use_cache is false.
+  Per collector status and timing goes to manifest.txt
+  When redactor is given, every output is redacted before being archived.
+*/
+static void run_collectors(string path, archive_t* archive, string prefix, time_t mtime, bool use_cache, const redactor_t* redactor)
+{
+    vector<collector_t> pending;
+    vector<collector_t> running;
+    vector<collector_t> finished;
+    set<string> scripts;
+    
+    vector<collector_t> natives;
+    
+    for (const auto& entry : std::filesystem::directory_iterator(path)) {
+        scripts.insert(entry.path().filename().string());
+    }
+    
+    for (const string& name : scripts) {
+        collector_t collector = {};
+        
+        collector.name = name;
+        collector.fd = -1;
+        collector.cacheable = collector_key(name, path + name, &collector.key);
+        pending.push_back(collector);
+    }
+    
+    for (const native_collector_t* native = native_collectors(); native->name; native++) {
+        if (scripts.count(native->name) == 0) {
+            collector_t collector = {};
+            
+            collector.name = native->name;
+            collector.fd = -1;
+            collector.collect = native->collect;
+            collector.cacheable = collector_key(native->name, "/proc/self/exe", &collector.key);
+            natives.push_back(collector);
+        }
+    }
+    
+    for (vector<collector_t>* list : {&pending, &natives}) {
+        for (size_t n = 0; use_cache and n < list->size(); n++) {
+            collector_t& collector = (*list)[n];
+            
+            if (collector.cacheable and collector_cache_get(collector.name, collector.key, collector.output)) {
+                collector.cached = true;
+                finish_collector(collector, archive, prefix, mtime, scripts, redactor);
+                finished.push_back(std::move(collector));
+                list->erase(list->begin() + n);
+                n--;
+            }
+        }
+    }
+    
+    mutex native_lock;
+    vector<collector_t> native_done;
+    size_t native_count = natives.size();
+    
+    /* some of them, as journal, take a while, never stall pipes and timeouts for them */
+    thread native_worker([&natives, &native_lock, &native_done]() {
+        for (collector_t& collector : natives) {
+            collector.start = chrono::steady_clock::now();
+            collector.status = collector.collect(collector.output);
+            collector.elapsed = chrono::steady_clock::now() - collector.start;
+            
+            lock_guard<mutex> guard(native_lock);
+            native_done.push_back(std::move(collector));
+        }
+    });
+    
+    /* taken from the back, so they start in name order */
+    std::reverse(pending.begin(), pending.end());
+    
+    while (pending.size() > 0 or running.size() > 0 or native_count > 0) {
+        while (pending.size() > 0 and running.size() < REPORT_JOBS) {
+            collector_t collector = pending.back();
+            pending.pop_back();
+            
+            collector.start = chrono::steady_clock::now();
+            collector.pid = spawn_collector(path + collector.name, &collector.fd);
+            
+            if (collector.pid < 0) {
+                collector.status = -1;
+                finished.push_back(collector);
+                continue;
+            }
+            
+            running.push_back(collector);
+        }
+        
+        {
+            lock_guard<mutex> guard(native_lock);
+            
+            for (collector_t& collector : native_done) {
+                finish_collector(collector, archive, prefix, mtime, scripts, redactor);
+                finished.push_back(std::move(collector));
+                native_count--;
+            }
+            
+            native_done.clear();
+        }
+        
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        chrono::steady_clock::time_point next = now + chrono::milliseconds(REPORT_TIMEOUT_MS);
+        vector<pollfd> fds;
+        
+        for (size_t n = 0; n < running.size(); n++) {
+            collector_t& collector = running[n];
+            chrono::steady_clock::time_point deadline = collector.start + chrono::milliseconds(REPORT_TIMEOUT_MS);
+            
+            if (!collector.timed_out and now >= deadline) {
+                kill(-collector.pid, SIGKILL);
+                collector.timed_out = true;
+            }
+            
+            if (!collector.exited and waitpid(collector.pid, &collector.status, WNOHANG) == collector.pid) {
+                collector.exited = true;
+            }
+            
+            /*
+              a child that left the process group survives the kill and may
+              hold the pipe forever, keep what was read so far
+            */
+            if (collector.timed_out and collector.exited and collector.fd >= 0) {
+                close(collector.fd);
+                collector.fd = -1;
+            }
+            
+            /* a background child may still hold the pipe, wait for both */
+            if (collector.exited and collector.fd < 0) {
+                collector.elapsed = chrono::steady_clock::now() - collector.start;
+                finish_collector(collector, archive, prefix, mtime, scripts, redactor);
+                finished.push_back(std::move(collector));
+                running.erase(running.begin() + n);
+                n--;
+                continue;
+            }
+            
+            if (!collector.timed_out and deadline < next) {
+                next = deadline;
+            }
+            
+            if (collector.fd >= 0) {
+                fds.push_back({collector.fd, POLLIN, 0});
+            }
+        }
+        
+        if (running.size() == 0 and native_count == 0) {
+            continue;
+        }
+        
+        /* exits are only noticed through waitpid, so never sleep long */
+        chrono::milliseconds wait = chrono::duration_cast<chrono::milliseconds>(next - now);
+        
+        if (wait > chrono::milliseconds(100)) {
+            wait = chrono::milliseconds(100);
+        }
+        
+        if (wait < chrono::milliseconds(1)) {
+            wait = chrono::milliseconds(1);
+        }
+        
+        if (poll(fds.data(), fds.size(), wait.count()) <= 0) {
+            continue;
+        }
+        
+        for (pollfd& pfd : fds) {
+            if (pfd.revents == 0) {
+                continue;
+            }
+            
+            for (collector_t& collector : running) {
+                if (collector.fd != pfd.fd) {
+                    continue;
+                }
+                
+                char buf[REPORT_BUFFER_SIZE];
+                ssize_t len = read(collector.fd, buf, sizeof(buf));
+                
+                if (len > 0) {
+                    collector.output.text.append(buf, len);
+                }
+                else if (len == 0 or errno != EINTR) {
+                    close(collector.fd);
+                    collector.fd = -1;
+                }
+                
+                break;
+            }
+        }
+    }
+    
+    native_worker.join();
+    
+    std::sort(finished.begin(), finished.end(), [](const collector_t& a, const collector_t& b) {
+        return a.name < b.name;
+    });
+    
+    stringstream manifest;
+    
+    for (collector_t& collector : finished) {
+        manifest<<collector.name<<" ";
         
-        if (ret > 0 and WIFEXITED(status)) {
-            return WEXITSTATUS(status);
+        if (collector.cached) {
+            manifest<<"cached";
+        }
+        else if (collector.collect) {
+            manifest<<"native:"<<collector.status;
+        }
+        else if (collector.status < 0) {
+            manifest<<"failed";
+        }
+        else if (collector.timed_out) {
+            manifest<<"timeout";
+        }
+        else if (WIFSIGNALED(collector.status)) {
+            manifest<<"signal:"<<WTERMSIG(collector.status);
+        }
+        else {
+            manifest<<"exit:"<<WEXITSTATUS(collector.status);
         }
         
-        return 1;
+        manifest<<" "<<chrono::duration_cast<chrono::milliseconds>(collector.elapsed).count()<<"ms\n";
     }
+    
+    archive_add(archive, prefix + "manifest.txt", manifest.str(), mtime);
 }
 
 static string trim(string in)
@@ -152,6 +487,16 @@ static string to_human(uint64_t value)
     
 }
 
+/* slimbookctl is setuid, commands working on user given trees must not run as root */
+static int drop_privileges()
+{
+    if (setgid(getgid()) != 0 or setuid(getuid()) != 0) {
+        return errno;
+    }
+    
+    return 0;
+}
+
 static string replace_ugly_chars(string in)
 {
     stringstream ss;
@@ -174,29 +519,33 @@ void show_help()
     cout<<"Usage: slimbookctl [command]"<<endl;
     cout<<"\n"<<endl;
     cout<<"Commands:"<<endl;
-    cout<<"info: display Slimbook model information"<<endl;
+    cout<<"info [--timings]: display Slimbook model information, optionally with time spent on each section"<<endl;
     cout<<"get-kbd-backlight: shows current keyboard backlight value in 32bit hexadecimal"<<endl;
     cout<<"set-kbd-backlight HEX: sets keyboard backlight as 32bit hexadecimal"<<endl;
     cout<<"get-kbd-brightness: shows current keyboard brightness value"<<endl;
     cout<<"set-kbd-brightness VALUE: sets keyboard brightness value [0-255]"<<endl;
     cout<<"config-load: loads module settings"<<endl;
     cout<<"config-store: stores module settings to disk"<<endl;
-    cout<<"report: creates a tar.gz with system information"<<endl;
-    cout<<"report-full: same as report, but it also gathers some sensible data as MAC address or board serial number"<<endl;
+    cout<<"config-export: prints stored settings as text"<<endl;
+    cout<<"suspend: saves state before sleeping, through slimbookd when it is running"<<endl;
+    cout<<"resume: restores state after sleeping, through slimbookd when it is running"<<endl;
+    cout<<"profile-save NAME: stores current hardware settings as profile NAME"<<endl;
+    cout<<"profile-apply NAME: switches hardware settings to profile NAME"<<endl;
+    cout<<"telemetry: shows last sensor values published by slimbookd"<<endl;
+    cout<<"monitor [--interval MS] [--binary]: streams fans, battery, AC, TDP, profile, temperatures and power every MS milliseconds (1000 by default) as JSON lines, only with fields that changed"<<endl;
+    cout<<"report [--no-cache]: creates a tar.gz with system information, output of collectors whose inputs did not change is reused unless --no-cache"<<endl;
+    cout<<"report-full [--no-cache]: same as report, but it also gathers some sensible data as MAC address or board serial number"<<endl;
+    cout<<"batch: runs commands read from stdin, one per line, answering each with a \"STATUS SIZE\" line followed by SIZE bytes of output"<<endl;
+    cout<<"bench [--json] [--baseline FILE] [--root DIR] [NAME...]: measures latency, syscalls and allocations of library calls matching NAME, comparing against a previous --json output, optionally against a fixture tree"<<endl;
+    cout<<"fixture DIR [MODEL]: writes a sysfs and procfs tree for each known model, or just MODEL, under DIR. Use it with SLB_ROOT or bench --root"<<endl;
+    cout<<"stats COMMAND [ARGS...]: runs COMMAND, or batch, and then shows calls, errors, latency, syscalls and EC writes of every library call it made on stderr"<<endl;
     cout<<"help: show this help"<<endl;
 }
 
-string get_info()
+static string info_system()
 {
     stringstream sout;
     
-    map<int,string> yesno = {{0,"no"},{1,"yes"}};
-    map<int,string> module_status_string = {{SLB_MODULE_NOT_LOADED,"no"},
-                                            {SLB_MODULE_LOADED,"yes"},
-                                            {SLB_MODULE_NOT_NEEDED,"not needed"},
-                                            {SLB_MODULE_UNKNOWN,"unknown"}
-                                            };
-    
     int64_t uptime = slb_info_uptime();
     int64_t h = uptime / 3600;
     int64_t m = (uptime / 60) % 60;
@@ -240,12 +589,21 @@ string get_info()
         ent = getmntent(mfile);
     }
     
+    endmntent(mfile);
+    
     // boot mode
 
-    sout << (std::filesystem::exists("/sys/firmware/efi") ? "boot mode: UEFI\n" : "boot mode: legacy\n");
+    sout << (device_exists("/sys/firmware/efi") ? "boot mode: UEFI\n" : "boot mode: legacy\n");
     
     sout<<"\n";
     
+    return sout.str();
+}
+
+static string info_dmi()
+{
+    stringstream sout;
+    
     sout<<"product: "<<slb_info_product_name()<<"\n";
     sout<<"sku: "<<slb_info_product_sku()<<"\n";
     sout<<"vendor: "<<slb_info_board_vendor()<<"\n";
@@ -263,6 +621,13 @@ string get_info()
 
     sout<<"\n";
     
+    return sout.str();
+}
+
+static string info_cpu()
+{
+    stringstream sout;
+    
     slb_smbios_entry_t* entries = nullptr;
     int count = 0;
 
@@ -296,7 +661,23 @@ string get_info()
 
                 sout << "\n";
             }
+        }
+        
+        slb_smbios_free(entries);
+    }
+    
+    return sout.str();
+}
 
+static string info_memory()
+{
+    stringstream sout;
+    
+    slb_smbios_entry_t* entries = nullptr;
+    int count = 0;
+
+    if (slb_smbios_get(&entries,&count) == 0) {
+        for (int n=0;n<count;n++) {
             if (entries[n].type == 17) {
                 if (entries[n].data.memory_device.type > 2) {
                     sout<<"memory device: "<<entries[n].data.memory_device.size<< (entries[n].data.memory_device.size_unit == 0 ? " MB " : " KB ") << entries[n].data.memory_device.speed<<" MT/s"<<"\n";
@@ -306,25 +687,21 @@ string get_info()
         
         slb_smbios_free(entries);
     }
+    
+    return sout.str();
+}
 
-    vector<string> modules = get_modules();
-    bool modFound = false;
-
-    for (string mod : modules) {
-        modFound = mod == "amdgpu" ? true : false;
-
-        if(modFound){
-            break;
-        }
-    }
-
-    if(modFound){
+static string info_vram()
+{
+    stringstream sout;
+    
+    if(module_loaded("amdgpu")){
         string vram_val = "1";
         char buf[55];
         
         for(int i = 0; i < 8; i++){
             snprintf(buf, sizeof(buf), SYS_AMDGPU"mem_info_vram_total", i);
-            if(filesystem::exists(buf)){
+            if(device_exists(buf)){
                 break;
             }
         }
@@ -337,7 +714,14 @@ string get_info()
     }
 
     sout<<"\n";
+    
+    return sout.str();
+}
 
+static string info_power()
+{
+    stringstream sout;
+    
     int ac_state;
     
     if (slb_info_get_ac_state(0, &ac_state) == 0) {
@@ -393,39 +777,60 @@ string get_info()
         sout << "battery info: " << (int)(bat.capacity) << "% " << stat + " " << charge << " mAh" << "\n";
     }
     
-    int module_status = slb_info_is_module_loaded();
-    uint32_t platform = slb_info_get_platform();
+    return sout.str();
+}
 
-    bool module_loaded = module_status == SLB_MODULE_LOADED;
+static string info_fans()
+{
+    stringstream sout;
     
-    if(module_loaded){
-        switch(platform){
-            case SLB_PLATFORM_QC71:
-                uint32_t fan1,fan2;
+    if(slb_info_is_module_loaded() == SLB_MODULE_LOADED){
+        uint32_t fan1 = -1;
+        uint32_t fan2 = -1;
 
+        switch(slb_info_get_platform()){
+            case SLB_PLATFORM_QC71:
                 slb_qc71_primary_fan_get(&fan1);
                 slb_qc71_secondary_fan_get(&fan2);
-
-                sout << "primary fan speed: " << fan1 << " RPM" << "\n";
-                sout << "secondary fan speed: " << fan2 << " RPM" << "\n"; 
-
                 break;
 
             case SLB_PLATFORM_CLEVO:
-                //todo
+                slb_clevo_primary_fan_get(&fan1);
+                slb_clevo_secondary_fan_get(&fan2);
                 break;
         
             default:
                 break;
         }
+
+        if (fan1 != (uint32_t)-1) {
+            sout << "primary fan speed: " << fan1 << " RPM" << "\n";
+        }
+
+        if (fan2 != (uint32_t)-1) {
+            sout << "secondary fan speed: " << fan2 << " RPM" << "\n";
+        }
     }
     
     sout<<"\n";
+    
+    return sout.str();
+}
 
+static string info_model()
+{
+    stringstream sout;
+    
+    map<int,string> module_status_string = {{SLB_MODULE_NOT_LOADED,"no"},
+                                            {SLB_MODULE_LOADED,"yes"},
+                                            {SLB_MODULE_NOT_NEEDED,"not needed"},
+                                            {SLB_MODULE_UNKNOWN,"unknown"}
+                                            };
+    
     uint32_t model = slb_info_get_model();
     sout<<"model:0x"<<std::hex<<model<<"\n";
     
-    sout<<"platform:0x"<<platform<<"\n";
+    sout<<"platform:0x"<<slb_info_get_platform()<<"\n";
     
     sout<<"family:"<<slb_info_get_family_name()<<"\n";
     
@@ -435,11 +840,20 @@ string get_info()
         sout<<"confidence:"<<std::dec<<confidence<<"\n";
     }
     
-    sout<<"module loaded:"<<module_status_string[module_status]<<"\n";
+    sout<<"module loaded:"<<module_status_string[slb_info_is_module_loaded()]<<"\n";
     
     sout<<"\n";
     
-    if (module_loaded and platform == SLB_PLATFORM_QC71) {
+    return sout.str();
+}
+
+static string info_qc71()
+{
+    stringstream sout;
+    
+    map<int,string> yesno = {{0,"no"},{1,"yes"}};
+    
+    if (slb_info_is_module_loaded() == SLB_MODULE_LOADED and slb_info_get_platform() == SLB_PLATFORM_QC71) {
         uint32_t value = 0;
         
         slb_qc71_fn_lock_get(&value);
@@ -493,17 +907,118 @@ string get_info()
         sout<<"profile: "<<profile_name<<"\n";
     }
     
+    return sout.str();
+}
+
+struct info_section_t
+{
+    const char* name;
+    string (*collect)();
+};
+
+/*
+  sections are printed in this order, whatever order they finish in. cpu
+  takes longest, TDP comes from SMU whose transactions may sleep for 200 ms
+*/
+static const info_section_t info_sections[] = {
+    {"system", info_system},
+    {"dmi", info_dmi},
+    {"cpu", info_cpu},
+    {"memory", info_memory},
+    {"vram", info_vram},
+    {"power", info_power},
+    {"fans", info_fans},
+    {"model", info_model},
+    {"qc71", info_qc71},
+    {nullptr, nullptr}
+};
+
+#define INFO_WORKERS 4
+
+struct info_result_t
+{
+    string text;
+    chrono::steady_clock::duration elapsed;
+};
+
+/* shared with workers, each result is only written by the one that took its section */
+struct info_state_t
+{
+    atomic<size_t> next;
+    vector<info_result_t> results;
+};
+
+string get_info(bool timings)
+{
+    stringstream sout;
+    size_t count = 0;
+    
+    while (info_sections[count].name) {
+        count++;
+    }
+    
+    /* not thread safe, fill cached DMI info before spreading work */
+    slb_info_retrieve();
+    
+    info_state_t state_data;
+    info_state_t* state = &state_data;
+    vector<thread> workers;
+    
+    state->next = 0;
+    state->results.resize(count, {"", {}});
+    
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    
+    for (int n = 0; n < INFO_WORKERS; n++) {
+        workers.emplace_back([state, count]() {
+            size_t index;
+            
+            while ((index = state->next++) < count) {
+                chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+                info_result_t& result = state->results[index];
+                
+                result.text = info_sections[index].collect();
+                result.elapsed = chrono::steady_clock::now() - begin;
+            }
+        });
+    }
+    
+    /* sections run on library state, all of them must finish before anyone else touches it */
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    
+    stringstream stimings;
+    
+    stimings<<"\ntimings:\n";
+    
+    for (size_t n = 0; n < count; n++) {
+        const info_section_t& section = info_sections[n];
+        info_result_t& result = state->results[n];
+        
+        sout<<result.text;
+        stimings<<section.name<<": "<<std::fixed<<std::setprecision(2)
+                <<chrono::duration<double,milli>(result.elapsed).count()<<" ms\n";
+    }
+    
+    stimings<<"total: "<<std::fixed<<std::setprecision(2)
+            <<chrono::duration<double,milli>(chrono::steady_clock::now() - start).count()<<" ms\n";
+    
+    if (timings) {
+        sout<<stimings.str();
+    }
+    
     sout<<std::flush;
     return sout.str();
 }
 
-void show_info()
+void show_info(bool timings)
 {
-    string info = get_info();
+    string info = get_info(timings);
     cout<<info;
 }
 
-int main(int argc,char* argv[])
+static int run_command(int argc,char* argv[])
 {
     string command;
     
@@ -516,7 +1031,7 @@ int main(int argc,char* argv[])
     }
     
     if (command == "info") {
-        show_info();
+        show_info(argc > 2 and string(argv[2]) == "--timings");
         return 0;
     }
     
@@ -526,7 +1041,7 @@ int main(int argc,char* argv[])
     }
     
     if (command == "set-kbd-backlight") {
-        if (argc<2) {
+        if (argc<3) {
             show_help();
             return 1; //better return value
         }
@@ -558,7 +1073,7 @@ int main(int argc,char* argv[])
     }
     
     if (command == "set-kbd-brightness") {
-        if (argc<2) {
+        if (argc<3) {
             show_help();
             return 1; //better return value
         }
@@ -591,7 +1106,7 @@ int main(int argc,char* argv[])
     
     /* Experimental! */
     if (command == "set-custom-tdp") {
-        if (argc < 4) {
+        if (argc < 5) {
             show_help();
             return 1;
         }
@@ -643,60 +1158,260 @@ int main(int argc,char* argv[])
         clog<<status<<endl;
     }
 
-    if (command == "serial") {
-        cout<<slb_info_product_serial()<<"\n";
+    if (command == "suspend" or command == "resume") {
+        int fd = daemon_connect();
+        
+        if (fd >= 0) {
+            daemon_request_t request = {};
+            daemon_response_t response;
+            
+            request.op = command == "suspend" ? DAEMON_OP_SUSPEND : DAEMON_OP_RESUME;
+            int status = daemon_call(fd, &request, &response);
+            
+            close(fd);
+            
+            if (status == 0) {
+                return response.status;
+            }
+        }
+        
+        /* no daemon, or it timed out, do it the slow way */
+        command = command == "suspend" ? "config-store" : "config-load";
     }
-    
-    if (command == "report") {
-        setenv(SLB_REPORT_PRIVATE,"1",1);
-        command = "report-full";
+
+    if (command == "config-export") {
+        Configuration conf;
+        conf.load();
+        cout<<conf.text();
     }
-    
-    if (command == "report-full") {
+
+    if (command == "profile-save" or command == "profile-apply") {
+        if (argc < 3) {
+            show_help();
+            return 1;
+        }
         
-        string id = generate_id();
-        string tmp_name = "/tmp/slimbook-report-" + id + "/";
-        std::filesystem::create_directory(tmp_name);
+        int status;
         
-        // store info
-        string info = get_info();
-        fstream finfo;
-        finfo.open(tmp_name+"info.txt",fstream::out);
+        if (command == "profile-save") {
+            slb_profile_t profile;
+            
+            status = slb_profile_capture(&profile);
+            
+            if (status == 0) {
+                status = slb_profile_set(argv[2],&profile);
+            }
+        }
+        else {
+            status = slb_profile_apply(argv[2]);
+        }
         
-        if (finfo.good()) {
-            finfo<<info;
-            finfo.close();
+        if (status > 0) {
+            cerr<<"Failed to "<<(command == "profile-save" ? "save" : "apply")<<" profile "<<argv[2]<<":"<<status<<endl;
+            return status;
         }
-        // else throw error?
-    
-        for (const auto& entry : std::filesystem::directory_iterator("/usr/libexec/slimbook/report.d/")) {
-            clog<<" running "<<entry.path().filename().string()<<" ";
-            string output = tmp_name + entry.path().filename().string() + ".txt";
-            int status = run_command(entry.path(),{output});
+        
+        return 0;
+    }
+
+    if (command == "telemetry") {
+        slb_telemetry_t telemetry;
+        int status = slb_telemetry_read(&telemetry);
+        
+        if (status > 0) {
+            cerr<<"No telemetry available:"<<status<<endl;
+            return status;
+        }
+        
+        cout<<"generation:"<<telemetry.generation<<"\n";
+        
+        if (telemetry.valid & SLB_TELEMETRY_QC71_PRIMARY_FAN) {
+            cout<<"primary fan:"<<telemetry.qc71_primary_fan<<"\n";
+        }
+        
+        if (telemetry.valid & SLB_TELEMETRY_QC71_SECONDARY_FAN) {
+            cout<<"secondary fan:"<<telemetry.qc71_secondary_fan<<"\n";
+        }
+        
+        if (telemetry.valid & SLB_TELEMETRY_CLEVO_PRIMARY_FAN) {
+            cout<<"primary fan:"<<telemetry.clevo_primary_fan<<"\n";
+        }
+        
+        if (telemetry.valid & SLB_TELEMETRY_CLEVO_SECONDARY_FAN) {
+            cout<<"secondary fan:"<<telemetry.clevo_secondary_fan<<"\n";
+        }
+        
+        if (telemetry.valid & SLB_TELEMETRY_BATTERY) {
+            cout<<"battery:"<<telemetry.battery_capacity<<"%\n";
+        }
+        
+        if (telemetry.valid & SLB_TELEMETRY_AC_STATE) {
+            cout<<"ac:"<<telemetry.ac_state<<"\n";
+        }
+        
+        if (telemetry.valid & SLB_TELEMETRY_TDP) {
+            cout<<"tdp:"<<telemetry.tdp_slow<<" "<<telemetry.tdp_fast<<" "<<telemetry.tdp_sustained<<"\n";
+        }
+        
+        return 0;
+    }
+
+    if (command == "monitor") {
+        uint32_t interval = MONITOR_DEFAULT_INTERVAL_MS;
+        int format = MONITOR_FORMAT_JSON;
+        
+        for (int n = 2; n < argc; n++) {
+            string arg = argv[n];
             
-            if (status == 0) {
-                clog<<"✓"<<endl;
+            if (arg == "--binary") {
+                format = MONITOR_FORMAT_BINARY;
+            }
+            else if (arg == "--interval" and n + 1 < argc) {
+                interval = std::stoi(argv[++n],0,0);
             }
             else {
-                if (status == 200) {
-                    clog<<"⚑"<<endl;
-                }
-                else {
-                    clog<<"✗"<<endl;
+                cerr<<"Unknown monitor option "<<arg<<endl;
+                return EINVAL;
+            }
+        }
+        
+        int status = monitor_run(interval, format);
+        
+        if (status != 0) {
+            cerr<<"Monitor failed:"<<status<<endl;
+        }
+        
+        return status;
+    }
+    
+    if (command == "bench") {
+        vector<string> filters;
+        string baseline;
+        bool json = false;
+        
+        for (int n = 2; n < argc; n++) {
+            string arg = argv[n];
+            
+            if (arg == "--json") {
+                json = true;
+            }
+            else if (arg == "--baseline" and n + 1 < argc) {
+                baseline = argv[++n];
+            }
+            else if (arg == "--root" and n + 1 < argc) {
+                int status = drop_privileges();
+                
+                if (status != 0) {
+                    cerr<<"Failed to drop privileges:"<<status<<endl;
+                    return status;
                 }
+                
+                slb_root_set(argv[++n]);
+            }
+            else {
+                filters.push_back(arg);
             }
         }
-
+        
+        return bench_run(filters, json, baseline);
+    }
+    
+    if (command == "fixture") {
+        if (argc < 3) {
+            cerr<<"Missing fixture directory"<<endl;
+            return EINVAL;
+        }
+        
+        int status = drop_privileges();
+        
+        if (status != 0) {
+            cerr<<"Failed to drop privileges:"<<status<<endl;
+            return status;
+        }
+        
+        string dir = argv[2];
+        
+        for (database_entry_t* entry = database; entry->model > 0; entry++) {
+            string name = fixture_name(entry);
+            
+            if (argc > 3 and name != argv[3]) {
+                continue;
+            }
+            
+            status = fixture_create(dir + "/" + name, entry);
+            
+            if (status != 0) {
+                cerr<<"Failed to create fixture "<<name<<":"<<status<<endl;
+                return status;
+            }
+            
+            /* as info shows it, so tests can check detection */
+            cout<<"fixture "<<dir<<"/"<<name<<" model:0x"<<std::hex<<entry->model<<std::dec<<endl;
+        }
+        
+        return 0;
+    }
+    
+    if (command == "serial") {
+        cout<<slb_info_product_serial()<<"\n";
+    }
+    
+    if (command == "report") {
+        setenv(SLB_REPORT_PRIVATE,"1",1);
+        command = "report-full";
+    }
+    
+    if (command == "report-full") {
+        
         std::time_t now = std::time(NULL);
         std::tm time = *std::localtime(&now);
         stringstream stream;
 
         stream << std::put_time(&time, "%F-%H-%M-%S");
         string name = "slimbook-report-" + stream.str();
+        string path = "/tmp/" + name + "-" + generate_id() + ".tar.gz";
+        
+        int status;
+        archive_t* archive = archive_open(path.c_str(), &status);
+        
+        if (!archive) {
+            cerr<<"Failed to create "<<path<<":"<<status<<endl;
+            return status;
+        }
+        
+        /* entries go under a directory named as the report */
+        string prefix = name + "/";
+        
+        /* private reports get identifying data scrubbed from every entry */
+        redactor_t* redactor = nullptr;
+        const char* private_report = getenv(SLB_REPORT_PRIVATE);
+        
+        if (private_report and string(private_report) == "1") {
+            redactor = redactor_alloc();
+        }
+        
+        string info = get_info(false);
+        
+        if (redactor) {
+            redact(redactor, info);
+        }
+        
+        archive_add(archive, prefix + "info.txt", std::move(info), now);
+        
+        run_collectors(REPORT_D, archive, prefix, now, !(argc > 2 and string(argv[2]) == "--no-cache"), redactor);
+        
+        redactor_free(redactor);
+        status = archive_close(archive);
+        
+        if (status != 0) {
+            cerr<<"Failed to write "<<path<<":"<<status<<endl;
+            unlink(path.c_str());
+            return status;
+        }
 
-        run_command("/usr/libexec/slimbook/report-pack", {tmp_name, name}); 
-
-        cout<<"report " << tmp_name << name << ".tar.gz" << endl; 
+        cout<<"report " << path << endl; 
+        
+        return 0;
     }
     
     if (command == "show-dmi") {
@@ -712,3 +1427,189 @@ int main(int argc,char* argv[])
     
     return 0;
 }
+
+/*
+  Reads one command per line from stdin and runs each of them in this
+  process, so model detection and library caches are shared among them.
+  Every command gets a framed response on stdout: a header line with exit
+  status and payload size in bytes, followed by exactly that many bytes of
+  command output. Diagnostics still go to stderr, unframed.
+*/
+static int run_batch()
+{
+    /* report turns private mode on, do not let it leak into next commands */
+    const char* env = getenv(SLB_REPORT_PRIVATE);
+    bool private_set = env != nullptr;
+    string private_value = private_set ? env : "";
+    
+    string line;
+    
+    while (std::getline(std::cin, line)) {
+        vector<string> words;
+        stringstream tokens(line);
+        string word;
+        
+        while (tokens >> word) {
+            words.push_back(word);
+        }
+        
+        if (words.empty()) {
+            continue;
+        }
+        
+        vector<char*> args;
+        args.push_back((char*)"slimbookctl");
+        
+        for (string& w : words) {
+            args.push_back((char*)w.c_str());
+        }
+        
+        args.push_back(nullptr);
+        
+        stringstream payload;
+        int status;
+        
+        /*
+          monitor never ends and writes to stdout on its own, fixture and
+          bench --root drop privileges and switch root for good
+        */
+        if (words[0] == "batch" or words[0] == "monitor" or words[0] == "stats" or
+            words[0] == "fixture" or words[0] == "bench") {
+            cerr<<words[0]<<" can not run in batch mode"<<endl;
+            status = EINVAL;
+        }
+        else {
+            std::streambuf* out = cout.rdbuf(payload.rdbuf());
+            
+            /* a bad argument must only fail its own command, not the whole batch */
+            try {
+                status = run_command(args.size() - 1, args.data());
+            }
+            catch (std::out_of_range&) {
+                cerr<<words[0]<<": value out of range"<<endl;
+                status = ERANGE;
+            }
+            catch (std::exception& e) {
+                cerr<<words[0]<<": "<<e.what()<<endl;
+                status = EINVAL;
+            }
+            
+            cout.rdbuf(out);
+        }
+        
+        if (private_set) {
+            setenv(SLB_REPORT_PRIVATE, private_value.c_str(), 1);
+        }
+        else {
+            unsetenv(SLB_REPORT_PRIVATE);
+        }
+        
+        string data = payload.str();
+        cout<<status<<" "<<data.size()<<"\n"<<data<<std::flush;
+    }
+    
+    return 0;
+}
+
+/* mean latency of timed calls, in ns */
+static uint64_t stats_mean(const slb_stats_t& entry)
+{
+    return entry.timed ? entry.total_ns / entry.timed : 0;
+}
+
+/* upper bound, in ns, of histogram bucket holding given fraction of calls */
+static uint64_t stats_percentile(const slb_stats_t& entry, double fraction)
+{
+    uint64_t target = entry.timed * fraction;
+    uint64_t seen = 0;
+    
+    if (entry.timed == 0) {
+        return 0;
+    }
+    
+    for (int n = 0; n < SLB_STATS_BUCKETS; n++) {
+        seen += entry.buckets[n];
+        
+        if (seen > target) {
+            return 1ULL << n;
+        }
+    }
+    
+    return 1ULL << (SLB_STATS_BUCKETS - 1);
+}
+
+/*
+  Runs a command, or a batch, and then writes to stderr every library call
+  it made, slowest first in total time. Latency figures come from sampled
+  calls, and percentiles are histogram bucket upper bounds, so within a
+  factor of two.
+*/
+static int run_stats(int argc,char* argv[])
+{
+    if (argc < 2) {
+        cerr<<"Missing command to measure"<<endl;
+        return EINVAL;
+    }
+    
+    slb_stats_enable(1);
+    slb_stats_reset();
+    
+    int status;
+    
+    if (string(argv[1]) == "batch") {
+        status = run_batch();
+    }
+    else {
+        status = run_command(argc, argv);
+    }
+    
+    int count = 0;
+    slb_stats_get(nullptr, &count);
+    
+    vector<slb_stats_t> stats(count);
+    slb_stats_get(stats.data(), &count);
+    
+    std::sort(stats.begin(), stats.end(), [](const slb_stats_t& a, const slb_stats_t& b) {
+        return stats_mean(a) * a.calls > stats_mean(b) * b.calls;
+    });
+    
+    cerr<<"call                             calls  errors   mean(ns)    p50(ns)    p99(ns)  syscalls  ec_writes\n";
+    
+    for (slb_stats_t& entry : stats) {
+        if (entry.calls == 0) {
+            continue;
+        }
+        
+        cerr.width(32);
+        cerr<<std::left<<entry.name<<std::right;
+        cerr.width(6);
+        cerr<<entry.calls<<" ";
+        cerr.width(7);
+        cerr<<entry.errors<<" ";
+        cerr.width(10);
+        cerr<<stats_mean(entry)<<" ";
+        cerr.width(10);
+        cerr<<stats_percentile(entry, 0.5)<<" ";
+        cerr.width(10);
+        cerr<<stats_percentile(entry, 0.99)<<" ";
+        cerr.width(9);
+        cerr<<entry.syscalls<<" ";
+        cerr.width(10);
+        cerr<<entry.ec_writes<<"\n";
+    }
+    
+    return status;
+}
+
+int main(int argc,char* argv[])
+{
+    if (argc > 1 and string(argv[1]) == "batch") {
+        return run_batch();
+    }
+    
+    if (argc > 1 and string(argv[1]) == "stats") {
+        return run_stats(argc - 1, argv + 1);
+    }
+    
+    return run_command(argc, argv);
+}
@@ -0,0 +1,654 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "slimbook.h"
+#include "daemon.h"
+#include "telemetry.h"
+
+#include <sys/socket.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <string>
+
+using namespace std;
+
+struct attribute_t
+{
+    uint32_t id;
+    /* how long a get is served from cache */
+    uint32_t ttl_ms;
+    /* whether unprivileged clients may set it */
+    bool user_settable;
+    /* highest value accepted from clients */
+    uint32_t max;
+    int (*get)(uint32_t model, uint32_t* values);
+    int (*set)(uint32_t model, const uint32_t* values);
+};
+
+struct cache_t
+{
+    bool valid;
+    int32_t status;
+    uint32_t values[DAEMON_VALUES];
+    chrono::steady_clock::time_point stamp;
+};
+
+struct client_t
+{
+    uid_t uid = 0;
+    bool subscribed = false;
+    /* partial request read so far */
+    uint8_t in[sizeof(daemon_request_t)];
+    size_t in_len = 0;
+    /* responses and notifications not taken by client yet */
+    string out;
+    /* when client last made progress with a partial request or pending output */
+    chrono::steady_clock::time_point stamp;
+};
+
+static const attribute_t attributes[] = {
+    {DAEMON_ATTR_KBD_BACKLIGHT, 60000, true, 0xffffff,
+        [](uint32_t model, uint32_t* v) { return slb_kbd_backlight_get(model, &v[0]); },
+        [](uint32_t model, const uint32_t* v) { return slb_kbd_backlight_set(model, v[0]); }},
+    {DAEMON_ATTR_KBD_BRIGHTNESS, 60000, true, 0xff,
+        [](uint32_t model, uint32_t* v) { return slb_kbd_brightness_get(model, &v[0]); },
+        [](uint32_t model, const uint32_t* v) { return slb_kbd_brightness_set(model, v[0]); }},
+    {DAEMON_ATTR_KBD_BRIGHTNESS_MAX, 3600000, false, 0,
+        [](uint32_t model, uint32_t* v) { return slb_kbd_brightness_max(model, &v[0]); },
+        nullptr},
+    {DAEMON_ATTR_QC71_MANUAL_CONTROL, 60000, false, 1,
+        [](uint32_t, uint32_t* v) { return slb_qc71_manual_control_get(&v[0]); },
+        [](uint32_t, const uint32_t* v) { return slb_qc71_manual_control_set(v[0]); }},
+    /* locks and modes can be toggled from keyboard, keep their cache short */
+    {DAEMON_ATTR_QC71_FN_LOCK, 1000, true, 1,
+        [](uint32_t, uint32_t* v) { return slb_qc71_fn_lock_get(&v[0]); },
+        [](uint32_t, const uint32_t* v) { return slb_qc71_fn_lock_set(v[0]); }},
+    {DAEMON_ATTR_QC71_SUPER_LOCK, 1000, true, 1,
+        [](uint32_t, uint32_t* v) { return slb_qc71_super_lock_get(&v[0]); },
+        [](uint32_t, const uint32_t* v) { return slb_qc71_super_lock_set(v[0]); }},
+    {DAEMON_ATTR_QC71_SILENT_MODE, 1000, true, 1,
+        [](uint32_t, uint32_t* v) { return slb_qc71_silent_mode_get(&v[0]); },
+        [](uint32_t, const uint32_t* v) { return slb_qc71_silent_mode_set(v[0]); }},
+    {DAEMON_ATTR_QC71_TURBO_MODE, 1000, false, 1,
+        [](uint32_t, uint32_t* v) { return slb_qc71_turbo_mode_get(&v[0]); },
+        [](uint32_t, const uint32_t* v) { return slb_qc71_turbo_mode_set(v[0]); }},
+    {DAEMON_ATTR_QC71_PROFILE, 1000, true, SLB_QC71_PROFILE_PERFORMANCE,
+        [](uint32_t, uint32_t* v) { return slb_qc71_profile_get(&v[0]); },
+        [](uint32_t, const uint32_t* v) { return slb_qc71_profile_set(v[0]); }},
+    {DAEMON_ATTR_QC71_CUSTOM_TDP, 1000, false, 0xff,
+        [](uint32_t, uint32_t* v) { return slb_qc71_custom_tdp_get(&v[0], &v[1], &v[2]); },
+        [](uint32_t, const uint32_t* v) { return slb_qc71_custom_tdp_set(v[0], v[1], v[2]); }},
+    {DAEMON_ATTR_QC71_PRIMARY_FAN, 500, false, 0,
+        [](uint32_t, uint32_t* v) { return slb_qc71_primary_fan_get(&v[0]); },
+        nullptr},
+    {DAEMON_ATTR_QC71_SECONDARY_FAN, 500, false, 0,
+        [](uint32_t, uint32_t* v) { return slb_qc71_secondary_fan_get(&v[0]); },
+        nullptr},
+    {DAEMON_ATTR_CLEVO_PRIMARY_FAN, 500, false, 0,
+        [](uint32_t, uint32_t* v) { return slb_clevo_primary_fan_get(&v[0]); },
+        nullptr},
+    {DAEMON_ATTR_CLEVO_SECONDARY_FAN, 500, false, 0,
+        [](uint32_t, uint32_t* v) { return slb_clevo_secondary_fan_get(&v[0]); },
+        nullptr},
+    {DAEMON_ATTR_BATTERY, 2000, false, 0,
+        [](uint32_t, uint32_t* v) {
+            slb_sys_battery_info info = {};
+            int status = slb_battery_info_get(&info);
+            v[0] = info.capacity;
+            v[1] = info.charge;
+            v[2] = info.status;
+            return status;
+        },
+        nullptr},
+    {DAEMON_ATTR_AC_STATE, 1000, false, 0,
+        [](uint32_t, uint32_t* v) {
+            int state = 0;
+            int status = slb_info_get_ac_state(0, &state);
+            v[0] = state;
+            return status;
+        },
+        nullptr},
+    /* an SMU transaction can sleep for 200 ms */
+    {DAEMON_ATTR_TDP_INFO, 5000, false, 0,
+        [](uint32_t, uint32_t* v) {
+            slb_tdp_info_t tdp = slb_info_get_tdp_info();
+            v[0] = tdp.slow;
+            v[1] = tdp.fast;
+            v[2] = tdp.sustained;
+            v[3] = tdp.type;
+            return 0;
+        },
+        nullptr},
+    {0, 0, false, 0, nullptr, nullptr}
+};
+
+static cache_t cache[DAEMON_ATTR_MAX];
+
+/* hardware state as we last saw it, restored on resume */
+static slb_profile_t state;
+
+/* state as it was last written to disk */
+static slb_profile_t stored;
+
+static vector<pollfd> fds;
+static vector<client_t> clients;
+
+/* fds and clients share index, first fds are signals, listening socket and telemetry timer */
+#define FIRST_CLIENT 3
+
+#define TELEMETRY_INTERVAL_MS 1000
+
+/* a client stuck in the middle of a request, or not reading its responses, is dropped after this */
+#define CLIENT_STALL_MS 2000
+
+/* pending output above this drops client */
+#define CLIENT_OUT_MAX (64 * sizeof(daemon_response_t))
+
+static int open_socket()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SLB_DAEMON_SOCKET, sizeof(addr.sun_path) - 1);
+
+    unlink(SLB_DAEMON_SOCKET);
+
+    /* anyone may connect, requests are checked against peer credentials */
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 or
+        chmod(SLB_DAEMON_SOCKET, 0666) < 0 or
+        listen(fd, 8) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static const attribute_t* find_attribute(uint32_t id)
+{
+    for (const attribute_t* attr = attributes; attr->id; attr++) {
+        if (attr->id == id) {
+            return attr;
+        }
+    }
+
+    return nullptr;
+}
+
+/* writes as much pending output as socket takes. Returns false if client has to be dropped */
+static bool flush_client(size_t n)
+{
+    client_t& client = clients[n];
+
+    while (!client.out.empty()) {
+        ssize_t ret = send(fds[n].fd, client.out.data(), client.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN or errno == EWOULDBLOCK) {
+                break;
+            }
+
+            return false;
+        }
+
+        client.out.erase(0, ret);
+        client.stamp = chrono::steady_clock::now();
+    }
+
+    fds[n].events = client.out.empty() ? POLLIN : POLLIN | POLLOUT;
+
+    return client.out.size() <= CLIENT_OUT_MAX;
+}
+
+/* queues a response for client, never waiting for it to read */
+static bool queue_response(size_t n, const daemon_response_t& response)
+{
+    client_t& client = clients[n];
+
+    if (client.out.empty()) {
+        client.stamp = chrono::steady_clock::now();
+    }
+
+    client.out.append((const char*)&response, sizeof(response));
+
+    return flush_client(n);
+}
+
+static void notify(uint32_t id, const cache_t& entry)
+{
+    daemon_response_t response;
+
+    memset(&response, 0, sizeof(response));
+    response.status = entry.status;
+    response.op = DAEMON_OP_NOTIFY;
+    response.attr = id;
+    memcpy(response.values, entry.values, sizeof(response.values));
+
+    for (size_t n = FIRST_CLIENT; n < fds.size(); n++) {
+        if (!clients[n].subscribed) {
+            continue;
+        }
+
+        /* a subscriber that does not keep up gets dropped, never waited for */
+        if (!queue_response(n, response)) {
+            shutdown(fds[n].fd, SHUT_RDWR);
+            clients[n].subscribed = false;
+        }
+    }
+}
+
+static const cache_t& refresh(const attribute_t* attr, bool force)
+{
+    cache_t& entry = cache[attr->id];
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+    if (!force and entry.valid and now - entry.stamp < chrono::milliseconds(attr->ttl_ms)) {
+        return entry;
+    }
+
+    cache_t fresh;
+
+    memset(fresh.values, 0, sizeof(fresh.values));
+    fresh.status = attr->get(slb_info_get_model(), fresh.values);
+    fresh.valid = true;
+    fresh.stamp = now;
+
+    bool changed = entry.valid and (entry.status != fresh.status or memcmp(entry.values, fresh.values, sizeof(fresh.values)) != 0);
+
+    entry = fresh;
+
+    if (changed) {
+        notify(attr->id, entry);
+    }
+
+    return entry;
+}
+
+static void telemetry_update()
+{
+    slb_telemetry_t telemetry;
+
+    memset(&telemetry, 0, sizeof(telemetry));
+
+    struct {
+        uint32_t attr;
+        uint32_t bit;
+        uint32_t* fields[DAEMON_VALUES];
+    } map[] = {
+        {DAEMON_ATTR_QC71_PRIMARY_FAN, SLB_TELEMETRY_QC71_PRIMARY_FAN, {&telemetry.qc71_primary_fan}},
+        {DAEMON_ATTR_QC71_SECONDARY_FAN, SLB_TELEMETRY_QC71_SECONDARY_FAN, {&telemetry.qc71_secondary_fan}},
+        {DAEMON_ATTR_CLEVO_PRIMARY_FAN, SLB_TELEMETRY_CLEVO_PRIMARY_FAN, {&telemetry.clevo_primary_fan}},
+        {DAEMON_ATTR_CLEVO_SECONDARY_FAN, SLB_TELEMETRY_CLEVO_SECONDARY_FAN, {&telemetry.clevo_secondary_fan}},
+        {DAEMON_ATTR_BATTERY, SLB_TELEMETRY_BATTERY,
+            {&telemetry.battery_capacity, &telemetry.battery_charge, &telemetry.battery_status}},
+        {DAEMON_ATTR_AC_STATE, SLB_TELEMETRY_AC_STATE, {&telemetry.ac_state}},
+        {DAEMON_ATTR_TDP_INFO, SLB_TELEMETRY_TDP,
+            {&telemetry.tdp_slow, &telemetry.tdp_fast, &telemetry.tdp_sustained, &telemetry.tdp_type}},
+    };
+
+    /* refresh honours each attribute ttl, so SMU is not hit every tick */
+    for (auto& m : map) {
+        const cache_t& entry = refresh(find_attribute(m.attr), false);
+
+        /* fan getters report a missing sensor as -1 */
+        if (entry.status != 0 or entry.values[0] == (uint32_t)-1) {
+            continue;
+        }
+
+        telemetry.valid |= m.bit;
+
+        for (int n = 0; n < DAEMON_VALUES; n++) {
+            if (m.fields[n]) {
+                *m.fields[n] = entry.values[n];
+            }
+        }
+    }
+
+    telemetry_publish(&telemetry);
+}
+
+static void store_state()
+{
+    if (memcmp(&state, &stored, sizeof(state)) != 0) {
+        slb_config_store(0);
+        stored = state;
+    }
+}
+
+static int32_t handle_get(const daemon_request_t& request, daemon_response_t& response)
+{
+    const attribute_t* attr = find_attribute(request.attr);
+
+    if (attr == nullptr) {
+        return EINVAL;
+    }
+
+    /* model from client is ignored, it would pick which device paths root touches */
+    const cache_t& entry = refresh(attr, false);
+
+    memcpy(response.values, entry.values, sizeof(response.values));
+
+    return entry.status;
+}
+
+static int32_t handle_set(const daemon_request_t& request, const client_t& client)
+{
+    const attribute_t* attr = find_attribute(request.attr);
+
+    if (attr == nullptr or attr->set == nullptr) {
+        return EINVAL;
+    }
+
+    if (client.uid != 0 and !attr->user_settable) {
+        return EPERM;
+    }
+
+    for (int n = 0; n < 3; n++) {
+        if (request.values[n] > attr->max) {
+            return EINVAL;
+        }
+    }
+
+    /* client thread asked for it with slb_shadow_force, it has no effect here otherwise */
+    slb_shadow_force(request.flags & DAEMON_FLAG_FORCE);
+
+    /* always the detected model, never the one client asked for */
+    int32_t status = attr->set(slb_info_get_model(), request.values);
+
+    slb_shadow_force(0);
+
+    if (status == 0) {
+        /* a write may change other attributes too, ie: performance profile */
+        for (const attribute_t* a = attributes; a->id; a++) {
+            if (a->set != nullptr and cache[a->id].valid) {
+                refresh(a, true);
+            }
+        }
+    }
+
+    return status;
+}
+
+static int32_t handle(const daemon_request_t& request, daemon_response_t& response, client_t& client)
+{
+    switch (request.op) {
+        case DAEMON_OP_PING:
+            return 0;
+
+        case DAEMON_OP_SUSPEND:
+            if (client.uid != 0) {
+                return EPERM;
+            }
+
+            slb_profile_capture(&state);
+            store_state();
+            return 0;
+
+        case DAEMON_OP_RESUME:
+            if (client.uid != 0) {
+                return EPERM;
+            }
+
+            /* firmware may have changed anything while sleeping */
+            for (cache_t& entry : cache) {
+                entry.valid = false;
+            }
+
+            /* only what firmware reset while sleeping gets written */
+            return slb_profile_restore(&state);
+
+        case DAEMON_OP_GET:
+            return handle_get(request, response);
+
+        case DAEMON_OP_SET:
+            return handle_set(request, client);
+
+        case DAEMON_OP_SUBSCRIBE:
+            client.subscribed = true;
+            return 0;
+
+        default:
+            return EINVAL;
+    }
+}
+
+static void add_client(int lfd)
+{
+    /* clients are never waited for, a stalled one must not block the others */
+    int cfd = accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+
+    if (cfd < 0) {
+        return;
+    }
+
+    ucred cred;
+    socklen_t len = sizeof(cred);
+
+    if (getsockopt(cfd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        close(cfd);
+        return;
+    }
+
+    client_t client;
+
+    client.uid = cred.uid;
+    client.stamp = chrono::steady_clock::now();
+
+    fds.push_back({cfd, POLLIN, 0});
+    clients.push_back(std::move(client));
+}
+
+/* reads and serves every complete request available. Returns false if client has to be dropped */
+static bool serve_client(size_t n)
+{
+    client_t& client = clients[n];
+
+    while (true) {
+        ssize_t ret = recv(fds[n].fd, client.in + client.in_len, sizeof(client.in) - client.in_len, MSG_DONTWAIT);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno == EAGAIN or errno == EWOULDBLOCK;
+        }
+
+        if (ret == 0) {
+            return false;
+        }
+
+        client.in_len += ret;
+        client.stamp = chrono::steady_clock::now();
+
+        if (client.in_len < sizeof(client.in)) {
+            continue;
+        }
+
+        daemon_request_t request;
+        daemon_response_t response;
+
+        memcpy(&request, client.in, sizeof(request));
+        client.in_len = 0;
+
+        memset(&response, 0, sizeof(response));
+        response.op = request.op;
+        response.attr = request.attr;
+        response.status = handle(request, response, client);
+
+        if (!queue_response(n, response)) {
+            return false;
+        }
+    }
+}
+
+/* milliseconds until first stalled client has to be dropped, -1 if none */
+static int stall_timeout()
+{
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    int timeout = -1;
+
+    for (size_t n = FIRST_CLIENT; n < fds.size(); n++) {
+        if (clients[n].in_len == 0 and clients[n].out.empty()) {
+            continue;
+        }
+
+        auto left = chrono::duration_cast<chrono::milliseconds>(clients[n].stamp + chrono::milliseconds(CLIENT_STALL_MS) - now).count();
+        int ms = left < 0 ? 0 : left + 1;
+
+        if (timeout < 0 or ms < timeout) {
+            timeout = ms;
+        }
+    }
+
+    return timeout;
+}
+
+int main()
+{
+    sigset_t mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+
+    int sfd = signalfd(-1, &mask, SFD_CLOEXEC);
+    int lfd = open_socket();
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+
+    if (sfd < 0 or lfd < 0 or tfd < 0) {
+        cerr<<"slimbookd: failed to setup: "<<strerror(errno)<<endl;
+        return 1;
+    }
+
+    slb_info_retrieve();
+    slb_info_module_listener_start();
+    slb_config_load(0);
+    slb_profile_capture(&state);
+    stored = state;
+
+    /* readers just see no segment when this fails */
+    if (telemetry_create() == 0) {
+        itimerspec interval;
+
+        interval.it_interval.tv_sec = TELEMETRY_INTERVAL_MS / 1000;
+        interval.it_interval.tv_nsec = (TELEMETRY_INTERVAL_MS % 1000) * 1000000;
+        interval.it_value.tv_sec = 0;
+        interval.it_value.tv_nsec = 1;
+        timerfd_settime(tfd, 0, &interval, nullptr);
+    }
+
+    fds = {{sfd, POLLIN, 0}, {lfd, POLLIN, 0}, {tfd, POLLIN, 0}};
+    clients.resize(FIRST_CLIENT);
+
+    bool running = true;
+
+    while (running) {
+        if (poll(fds.data(), fds.size(), stall_timeout()) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            running = false;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            add_client(lfd);
+        }
+
+        if (fds[2].revents & POLLIN) {
+            uint64_t expirations;
+
+            if (read(tfd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                telemetry_update();
+            }
+        }
+
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+        for (size_t n = FIRST_CLIENT; n < fds.size(); n++) {
+            short revents = fds[n].revents;
+            bool drop = (revents & (POLLERR | POLLHUP | POLLNVAL)) and !(revents & POLLIN);
+
+            if (!drop and (revents & POLLOUT)) {
+                drop = !flush_client(n);
+            }
+
+            if (!drop and (revents & POLLIN)) {
+                drop = !serve_client(n);
+            }
+
+            /* half a request, or responses left unread, for too long */
+            bool pending = clients[n].in_len > 0 or !clients[n].out.empty();
+
+            if (!drop and pending and now - clients[n].stamp >= chrono::milliseconds(CLIENT_STALL_MS)) {
+                drop = true;
+            }
+
+            if (drop) {
+                close(fds[n].fd);
+                fds.erase(fds.begin() + n);
+                clients.erase(clients.begin() + n);
+                n--;
+            }
+        }
+    }
+
+    slb_profile_capture(&state);
+    store_state();
+
+    for (size_t n = FIRST_CLIENT; n < fds.size(); n++) {
+        close(fds[n].fd);
+    }
+
+    telemetry_destroy();
+    close(tfd);
+    close(lfd);
+    unlink(SLB_DAEMON_SOCKET);
+
+    return 0;
+}
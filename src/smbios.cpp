@@ -19,9 +19,11 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
 #include "slimbook.h"
+#include "common.h"
+#include "stats.h"
 
 #include <vector>
-#include <fstream>
+#include <sstream>
 #include <cstring>
 #include <iostream>
 
@@ -29,13 +31,21 @@ using namespace std;
 
 int slb_smbios_get(slb_smbios_entry_t** entries,int* count)
 {
+    STATS_CALL();
+
     vector<slb_smbios_entry_t> data;
 
-    ifstream file;
+    string table;
+
+    /* read at once, so the whole table is a single traced access */
+    if (read_device_file("/sys/firmware/dmi/tables/DMI", table) != 0) {
+        table.clear();
+    }
+
+    istringstream file(table);
 
     try {
-        file.open("/sys/firmware/dmi/tables/DMI",std::ifstream::binary);
-        while (file.good()) {
+        while (file.good() and !table.empty()) {
             slb_smbios_entry_t entry;
             streampos start = file.tellg();
 
@@ -43,6 +53,11 @@ int slb_smbios_get(slb_smbios_entry_t** entries,int* count)
             file.read((char*)&entry.length,1);
             file.read((char*)&entry.handle,2);
 
+            /* tables end right after last structure */
+            if (!file.good()) {
+                break;
+            }
+
             file.seekg(start);
 
             uint8_t raw[256];
@@ -57,7 +72,11 @@ int slb_smbios_get(slb_smbios_entry_t** entries,int* count)
 
             do {
                 char tmp;
-                file.read(&tmp,1);
+
+                if (!file.read(&tmp,1)) {
+                    break;
+                }
+
                 if (tmp == 0) {
                     if (end) {
                         break;
@@ -77,6 +96,11 @@ int slb_smbios_get(slb_smbios_entry_t** entries,int* count)
                 }
             } while (true);
 
+            /* a truncated structure is not worth returning */
+            if (!file.good()) {
+                break;
+            }
+
             if (entry.type == 4) {
                 entry.data.processor.cores = raw[0x23] == 0xFF ? *((uint16_t*)(&raw[0x23])) : raw[0x2A];
                 entry.data.processor.threads = raw[0x25] == 0xFF ? *((uint16_t*)(&raw[0x2E])) : raw[0x25];
@@ -96,11 +120,9 @@ int slb_smbios_get(slb_smbios_entry_t** entries,int* count)
 
             data.push_back(entry);
         }
-
-        file.close();
     }
     catch(...) {
-        return EIO;
+        STATS_RETURN(EIO);
     }
 
     *entries = (slb_smbios_entry_t* ) malloc(sizeof(slb_smbios_entry_t) * data.size());
@@ -108,15 +130,17 @@ int slb_smbios_get(slb_smbios_entry_t** entries,int* count)
 
     memcpy(*entries,data.data(),sizeof(slb_smbios_entry_t) * data.size());
 
-    return 0;
+    STATS_RETURN(0);
 }
 
 int slb_smbios_free(slb_smbios_entry_t* entries)
 {
+    STATS_CALL();
+
     if (entries) {
         free(entries);
     }
     
-    return 0;
+    STATS_RETURN(0);
 }
 
@@ -0,0 +1,267 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "stats.h"
+#include "slimbook.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+__thread stats_io_t stats_io = {0, 0, 0, 0};
+
+atomic<bool> stats_measuring(true);
+atomic<bool> stats_counting(true);
+atomic<bool> stats_spanning(false);
+
+/*
+  Counters are only written by their owner thread, with plain relaxed
+  loads and stores, and read by slb_stats_get from any thread.
+*/
+typedef struct {
+    atomic<uint64_t> calls;
+    atomic<uint64_t> timed;
+    atomic<uint64_t> errors;
+    atomic<uint64_t> syscalls;
+    atomic<uint64_t> ec_writes;
+    atomic<uint64_t> total_ns;
+    atomic<uint64_t> buckets[SLB_STATS_BUCKETS];
+} stats_counters_t;
+
+typedef struct {
+    stats_counters_t functions[STATS_MAX_FUNCTIONS];
+} stats_thread_t;
+
+static mutex stats_mutex;
+static char stats_names[STATS_MAX_FUNCTIONS][SLB_STATS_NAME_SIZE];
+static atomic<int> stats_count(0);
+
+/* live threads, and totals of finished ones */
+static vector<stats_thread_t*> stats_threads;
+static slb_stats_t stats_retired[STATS_MAX_FUNCTIONS];
+
+/* totals at last reset, subtracted from every snapshot */
+static slb_stats_t stats_baseline[STATS_MAX_FUNCTIONS];
+
+static void _stats_add(slb_stats_t* out, stats_counters_t* in)
+{
+    out->calls += in->calls.load(memory_order_relaxed);
+    out->timed += in->timed.load(memory_order_relaxed);
+    out->errors += in->errors.load(memory_order_relaxed);
+    out->syscalls += in->syscalls.load(memory_order_relaxed);
+    out->ec_writes += in->ec_writes.load(memory_order_relaxed);
+    out->total_ns += in->total_ns.load(memory_order_relaxed);
+
+    for (int n = 0; n < SLB_STATS_BUCKETS; n++) {
+        out->buckets[n] += in->buckets[n].load(memory_order_relaxed);
+    }
+}
+
+/* calling thread counters, set up by its stats_holder on first call */
+static __thread stats_thread_t* stats_current = nullptr;
+
+/* owns calling thread counters, folding them into retired ones on thread exit */
+class stats_holder
+{
+    public:
+
+    stats_thread_t* counters;
+
+    stats_holder()
+    {
+        counters = new stats_thread_t();
+
+        lock_guard<mutex> lock(stats_mutex);
+        stats_threads.push_back(counters);
+    }
+
+    ~stats_holder()
+    {
+        lock_guard<mutex> lock(stats_mutex);
+
+        for (int n = 0; n < STATS_MAX_FUNCTIONS; n++) {
+            _stats_add(&stats_retired[n], &counters->functions[n]);
+        }
+
+        stats_threads.erase(std::remove(stats_threads.begin(), stats_threads.end(), counters), stats_threads.end());
+        delete counters;
+        stats_current = nullptr;
+    }
+};
+
+/* caller holds stats_mutex */
+static void _stats_update()
+{
+    stats_measuring.store(stats_counting.load(memory_order_relaxed) or stats_spanning.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+void stats_enable(bool enable)
+{
+    lock_guard<mutex> lock(stats_mutex);
+
+    stats_counting.store(enable, memory_order_relaxed);
+    _stats_update();
+}
+
+void stats_timeline(bool enable)
+{
+    lock_guard<mutex> lock(stats_mutex);
+
+    stats_spanning.store(enable, memory_order_relaxed);
+    _stats_update();
+}
+
+/* ignored by setuid callers, which keep counting */
+static bool _stats_env()
+{
+    const char* env = secure_getenv(SLB_STATS_ENV);
+
+    if (env and strcmp(env, "0") == 0) {
+        stats_enable(false);
+    }
+
+    return true;
+}
+
+static bool stats_env_loaded = _stats_env();
+
+/* single writer, no need for a locked add */
+static inline void _stats_bump(atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+int stats_register(const char* name)
+{
+    lock_guard<mutex> lock(stats_mutex);
+
+    int id = stats_count.load(memory_order_relaxed);
+
+    if (id >= STATS_MAX_FUNCTIONS) {
+        return -1;
+    }
+
+    strncpy(stats_names[id], name, SLB_STATS_NAME_SIZE - 1);
+    stats_count.store(id + 1, memory_order_release);
+
+    return id;
+}
+
+static stats_thread_t* _stats_thread()
+{
+    static thread_local stats_holder holder;
+
+    stats_current = holder.counters;
+
+    return stats_current;
+}
+
+void stats_account(int id, bool timed, uint64_t duration, bool error, uint64_t syscalls, uint64_t ec_writes)
+{
+    if (id < 0) {
+        return;
+    }
+
+    stats_thread_t* thread = stats_current ? stats_current : _stats_thread();
+    stats_counters_t& counters = thread->functions[id];
+
+    _stats_bump(counters.calls, 1);
+
+    if (timed) {
+        /* bucket n holds [2^(n-1), 2^n) */
+        int bucket = duration == 0 ? 0 : 64 - __builtin_clzll(duration);
+
+        if (bucket >= SLB_STATS_BUCKETS) {
+            bucket = SLB_STATS_BUCKETS - 1;
+        }
+
+        _stats_bump(counters.timed, 1);
+        _stats_bump(counters.total_ns, duration);
+        _stats_bump(counters.buckets[bucket], 1);
+    }
+
+    if (error) {
+        _stats_bump(counters.errors, 1);
+    }
+
+    if (syscalls > 0) {
+        _stats_bump(counters.syscalls, syscalls);
+    }
+
+    if (ec_writes > 0) {
+        _stats_bump(counters.ec_writes, ec_writes);
+    }
+}
+
+/* sums all threads, caller holds stats_mutex */
+static void _stats_total(slb_stats_t* totals, int count)
+{
+    for (int n = 0; n < count; n++) {
+        totals[n] = stats_retired[n];
+
+        for (stats_thread_t* thread : stats_threads) {
+            _stats_add(&totals[n], &thread->functions[n]);
+        }
+    }
+}
+
+int stats_snapshot(slb_stats_t* stats, int count)
+{
+    lock_guard<mutex> lock(stats_mutex);
+
+    int tracked = stats_count.load(memory_order_acquire);
+
+    if (stats == nullptr) {
+        return tracked;
+    }
+
+    count = std::min(count, tracked);
+    _stats_total(stats, count);
+
+    for (int n = 0; n < count; n++) {
+        slb_stats_t& entry = stats[n];
+        slb_stats_t& base = stats_baseline[n];
+
+        memcpy(entry.name, stats_names[n], SLB_STATS_NAME_SIZE);
+        entry.calls -= base.calls;
+        entry.timed -= base.timed;
+        entry.errors -= base.errors;
+        entry.syscalls -= base.syscalls;
+        entry.ec_writes -= base.ec_writes;
+        entry.total_ns -= base.total_ns;
+
+        for (int b = 0; b < SLB_STATS_BUCKETS; b++) {
+            entry.buckets[b] -= base.buckets[b];
+        }
+    }
+
+    return tracked;
+}
+
+void stats_reset()
+{
+    lock_guard<mutex> lock(stats_mutex);
+
+    _stats_total(stats_baseline, stats_count.load(memory_order_acquire));
+}
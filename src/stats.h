@@ -0,0 +1,208 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_STATS_H
+#define SLB_STATS_H
+
+#include "slimbook.h"
+#include "timeline.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include <time.h>
+
+/* Environment variable that turns call counting off at load when set to 0 */
+#define SLB_STATS_ENV "SLB_STATS"
+
+/* public calls tracked, further ones are not accounted */
+#define STATS_MAX_FUNCTIONS 96
+
+/*
+  One call in this many, on average, has its latency measured. Gaps are
+  random so that a loop of calls does not always time the same one.
+*/
+#define STATS_SAMPLE_PERIOD 16
+
+/* I/O done by current thread, only ever growing, and its sampling state */
+typedef struct {
+    uint64_t syscalls;
+    uint64_t ec_writes;
+    uint32_t countdown;
+    uint32_t seed;
+} stats_io_t;
+
+extern __thread stats_io_t stats_io;
+
+/*
+  Set while calls are counted or a timeline is being collected, which is
+  the default. Public calls check it, with a single relaxed load, before
+  doing anything else.
+*/
+extern std::atomic<bool> stats_measuring;
+
+/* Calls are being counted, not just given timeline spans */
+extern std::atomic<bool> stats_counting;
+
+/* A timeline is being collected, so every call is timed */
+extern std::atomic<bool> stats_spanning;
+
+static inline bool stats_measured()
+{
+    return stats_measuring.load(std::memory_order_relaxed);
+}
+
+/* Turns call counting on or off */
+void stats_enable(bool enable);
+
+/* Turns call spans on or off, for timeline start and stop */
+void stats_timeline(bool enable);
+
+/* Accounts count syscalls done by library I/O helpers on behalf of current call */
+static inline void stats_syscalls(uint32_t count)
+{
+    if (stats_measured()) {
+        stats_io.syscalls += count;
+    }
+}
+
+/* Accounts a write reaching a platform driver attribute, thus the EC */
+static inline void stats_ec_write()
+{
+    if (stats_measured()) {
+        stats_io.ec_writes++;
+    }
+}
+
+/* Gets a slot for function name, or -1 once all of them are taken */
+int stats_register(const char* name);
+
+/* Accounts a finished call to function id, duration is only meaningful when timed */
+void stats_account(int id, bool timed, uint64_t duration, bool error, uint64_t syscalls, uint64_t ec_writes);
+
+/* Whether current call gets its latency measured, see STATS_SAMPLE_PERIOD */
+static inline bool stats_sampled(stats_io_t& io)
+{
+    if (io.countdown > 0) {
+        io.countdown--;
+        return false;
+    }
+
+    /* LCG, high bits are good enough for a gap in [1, 2 * period) */
+    io.seed = io.seed * 1664525 + 1013904223;
+    io.countdown = (io.seed >> 16) % (2 * STATS_SAMPLE_PERIOD - 1);
+
+    return true;
+}
+
+/* CLOCK_MONOTONIC nanoseconds, through vDSO */
+static inline uint64_t stats_clock()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+  Copies up to count tracked calls, merged from all threads and relative
+  to last reset, into stats. Returns number of calls tracked
+*/
+int stats_snapshot(slb_stats_t* stats, int count);
+
+/* Takes current totals as the new zero */
+void stats_reset();
+
+/*
+  Measures a public call from construction to destruction. Syscalls and
+  EC writes of nested public calls are also accounted to outer ones. Every
+  call is counted but only sampled ones read the clock, unless a timeline
+  is being collected and the call becomes a span. Does nothing but a flag
+  check once stats and timeline are off.
+*/
+class stats_scope
+{
+    public:
+
+    stats_scope(int id, const char* name) : id(id), name(name), status(0), measured(stats_measured()), timed(false), start(0)
+    {
+        if (measured) {
+            stats_io_t& io = stats_io;
+
+            syscalls = io.syscalls;
+            ec_writes = io.ec_writes;
+            timed = stats_sampled(io) or stats_spanning.load(std::memory_order_relaxed);
+
+            if (timed) {
+                start = stats_clock();
+            }
+        }
+    }
+
+    ~stats_scope()
+    {
+        if (!measured) {
+            return;
+        }
+
+        uint64_t duration = timed ? stats_clock() - start : 0;
+
+        if (stats_counting.load(std::memory_order_relaxed)) {
+            stats_io_t& io = stats_io;
+
+            stats_account(id, timed, duration, status != 0, io.syscalls - syscalls, io.ec_writes - ec_writes);
+        }
+
+        if (timed and timeline_enabled()) {
+            timeline_span(TIMELINE_CAT_API, name, nullptr, start, duration, status);
+        }
+    }
+
+    /* Marks call as failed when status is not 0, returns status */
+    template<typename T>
+    T result(T value)
+    {
+        status = value;
+
+        return value;
+    }
+
+    private:
+
+    int id;
+    const char* name;
+    int32_t status;
+    bool measured;
+    bool timed;
+    uint64_t start;
+    uint64_t syscalls;
+    uint64_t ec_writes;
+};
+
+/* First statement of every public call */
+#define STATS_CALL() \
+    static const int _stats_id = stats_register(__func__); \
+    stats_scope _stats(_stats_id, __func__)
+
+/* Returns an errno status from a public call, counting it as an error unless 0 */
+#define STATS_RETURN(status) return _stats.result(status)
+
+#endif
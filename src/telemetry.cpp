@@ -0,0 +1,231 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "telemetry.h"
+#include "common.h"
+#include "stats.h"
+
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static telemetry_segment_t* producer = nullptr;
+
+/* reader mapping, read only and shared by all threads */
+static atomic<telemetry_segment_t*> reader {nullptr};
+
+static uint64_t monotonic_ns()
+{
+    timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int telemetry_create()
+{
+    if (producer) {
+        return 0;
+    }
+
+    string path = root_path(SLB_TELEMETRY_PATH);
+
+    /* never open whatever is there, a fresh file can not be a planted one */
+    if (unlink(path.c_str()) < 0 and errno != ENOENT) {
+        return errno;
+    }
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        return errno;
+    }
+
+    if (ftruncate(fd, sizeof(telemetry_segment_t)) < 0) {
+        int status = errno;
+        close(fd);
+        return status;
+    }
+
+    void* addr = mmap(nullptr, sizeof(telemetry_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        return errno;
+    }
+
+    producer = (telemetry_segment_t*)addr;
+
+    /* file comes zeroed, magic goes last so readers never map a half set up segment */
+    producer->version = TELEMETRY_VERSION;
+    producer->size = sizeof(slb_telemetry_t);
+    atomic_thread_fence(memory_order_release);
+    producer->magic = TELEMETRY_MAGIC;
+
+    return 0;
+}
+
+int telemetry_publish(const slb_telemetry_t* data)
+{
+    if (!producer) {
+        return ENOENT;
+    }
+
+    uint32_t seq = producer->sequence.load(memory_order_relaxed);
+
+    producer->sequence.store(seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(&producer->data, data, sizeof(slb_telemetry_t));
+    producer->data.generation = (seq + 2) / 2;
+    producer->data.timestamp = monotonic_ns();
+
+    producer->sequence.store(seq + 2, memory_order_release);
+
+    return 0;
+}
+
+void telemetry_destroy()
+{
+    if (producer) {
+        uint32_t seq = producer->sequence.load(memory_order_relaxed);
+
+        producer->sequence.store(seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        producer->magic = 0;
+        producer->sequence.store(seq + 2, memory_order_release);
+
+        munmap(producer, sizeof(telemetry_segment_t));
+        producer = nullptr;
+    }
+}
+
+/*
+  Maps current segment in place of stale one, which is either nullptr or
+  a segment its producer marked as gone. Stale mappings are never unmapped
+  here, other threads may still be reading them.
+*/
+static telemetry_segment_t* reader_map(telemetry_segment_t* stale)
+{
+    int fd = open(root_path(SLB_TELEMETRY_PATH).c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 or !S_ISREG(st.st_mode) or st.st_size < (off_t)sizeof(telemetry_segment_t)) {
+        close(fd);
+        return nullptr;
+    }
+
+    /* only slimbookd may publish, fixture trees belong to whoever made them */
+    if (st.st_uid != 0 and !root_active()) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* addr = mmap(nullptr, sizeof(telemetry_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    telemetry_segment_t* segment = (telemetry_segment_t*)addr;
+
+    if (segment->magic != TELEMETRY_MAGIC or segment->version != TELEMETRY_VERSION) {
+        munmap(addr, sizeof(telemetry_segment_t));
+        return nullptr;
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+
+    telemetry_segment_t* expected = stale;
+
+    /* another thread got there first */
+    if (!reader.compare_exchange_strong(expected, segment, memory_order_acq_rel)) {
+        munmap(addr, sizeof(telemetry_segment_t));
+        segment = expected;
+    }
+
+    return segment;
+}
+
+int slb_telemetry_read(slb_telemetry_t* telemetry)
+{
+    STATS_CALL();
+
+    if (!telemetry) {
+        STATS_RETURN(EINVAL);
+    }
+
+    telemetry_segment_t* segment = reader.load(memory_order_acquire);
+
+    /* first call, or slimbookd was restarted */
+    if (!segment or segment->magic != TELEMETRY_MAGIC) {
+        segment = reader_map(segment);
+    }
+
+    if (!segment) {
+        STATS_RETURN(ENOENT);
+    }
+
+    /* writer only holds the lock for a memcpy, a stuck odd value means it died there */
+    for (int n = 0; n < 10000; n++) {
+        uint32_t begin = segment->sequence.load(memory_order_acquire);
+
+        if (begin & 1) {
+            continue;
+        }
+
+        memcpy(telemetry, &segment->data, sizeof(slb_telemetry_t));
+        atomic_thread_fence(memory_order_acquire);
+
+        if (segment->sequence.load(memory_order_relaxed) == begin) {
+            STATS_RETURN(0);
+        }
+    }
+
+    STATS_RETURN(EBUSY);
+}
+
+int slb_telemetry_close()
+{
+    STATS_CALL();
+
+    telemetry_segment_t* segment = reader.exchange(nullptr, memory_order_acq_rel);
+
+    if (segment) {
+        munmap(segment, sizeof(telemetry_segment_t));
+    }
+
+    STATS_RETURN(0);
+}
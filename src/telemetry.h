@@ -0,0 +1,58 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_TELEMETRY_H
+#define SLB_TELEMETRY_H
+
+#include "slimbook.h"
+
+#include <atomic>
+#include <cstdint>
+
+/* in slimbookd RuntimeDirectory, only root can create files there */
+#define SLB_TELEMETRY_DIR  "/run/slimbook"
+#define SLB_TELEMETRY_PATH SLB_TELEMETRY_DIR "/telemetry"
+
+#define TELEMETRY_MAGIC     0x4d4c4553
+#define TELEMETRY_VERSION   1
+
+/*
+  Segment layout. sequence is odd while the producer is writing, readers
+  copy data and retry until they see the same even sequence on both sides.
+*/
+struct telemetry_segment_t
+{
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+    uint32_t size;
+    slb_telemetry_t data;
+};
+
+/* Creates a new telemetry segment, replacing any previous file. Only one producer is expected */
+int telemetry_create();
+
+/* Publishes a new snapshot, generation and timestamp are filled here */
+int telemetry_publish(const slb_telemetry_t* data);
+
+/* Marks segment as gone, so readers map the next one, and unmaps it */
+void telemetry_destroy();
+
+#endif
@@ -0,0 +1,73 @@
+#!/bin/sh
+
+# Creates a fixture tree for every known model under $2 and checks that
+# slimbookctl $1, pointed at each of them through SLB_ROOT, detects the
+# model it was made from, reports its battery and fans, and reads back
+# what it writes to keyboard and TDP attributes the model has.
+
+ctl=$1
+dir=$2
+failed=0
+
+rm -rf "$dir"
+mkdir -p "$dir"
+
+"$ctl" fixture "$dir" > "$dir/models" || exit 1
+
+fail()
+{
+    echo "$root: $*"
+    failed=1
+}
+
+# runs set command with $2 and checks get command prints $3 back, models
+# without the attribute fail get with ENOENT or EIO and are skipped
+round_trip()
+{
+    SLB_ROOT="$root" "$ctl" "get-$1" > /dev/null 2>&1 || return 0
+
+    if ! SLB_ROOT="$root" "$ctl" "set-$1" $2 > /dev/null
+    then
+        fail "set-$1 $2 failed"
+        return
+    fi
+
+    value=$(SLB_ROOT="$root" "$ctl" "get-$1")
+
+    if [ "$value" != "$3" ]
+    then
+        fail "get-$1: expected $3, got ${value:-nothing}"
+    fi
+}
+
+while read -r _ root expected
+do
+    info=$(SLB_ROOT="$root" "$ctl" info)
+    found=$(echo "$info" | grep '^model:')
+
+    if [ "$found" != "$expected" ]
+    then
+        fail "expected $expected, got ${found:-nothing}"
+    fi
+
+    echo "$info" | grep -q '^battery info: [0-9]*%' || fail "no battery info"
+
+    # qc71 and clevo platforms expose fans through their hwmon
+    platform=$(echo "$info" | grep '^platform:')
+
+    if [ "$platform" = "platform:0x100" ] || [ "$platform" = "platform:0x200" ]
+    then
+        echo "$info" | grep -q '^primary fan speed: [0-9]* RPM' || fail "no fan speed"
+    fi
+
+    if [ "$platform" = "platform:0x100" ]
+    then
+        SLB_ROOT="$root" "$ctl" get-custom-tdp > /dev/null || fail "get-custom-tdp failed"
+    fi
+
+    round_trip kbd-brightness 2a 2a
+    round_trip kbd-backlight 00ff80 00ff80
+    round_trip custom-tdp "25 35 45" "25 35 45"
+done < "$dir/models"
+
+exit $failed
@@ -0,0 +1,138 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+  Checks profile capture, store and restore against a TITAN fixture tree
+  written under the directory given as only argument.
+*/
+
+#include "slimbook.h"
+#include "fixture.h"
+
+#include <iostream>
+#include <filesystem>
+#include <string>
+
+using namespace std;
+
+static int failed = 0;
+
+#define CHECK(cond) \
+    if (!(cond)) { \
+        cerr<<__func__<<":"<<__LINE__<<": "<<#cond<<endl; \
+        failed = 1; \
+    }
+
+/* as slimbookd does on resume, firmware has reset TDP and shadow is stale */
+static void fake_resume(uint32_t pl1, uint32_t pl2, uint32_t pl4)
+{
+    slb_qc71_custom_tdp_set(pl1, pl2, pl4);
+    slb_shadow_invalidate();
+}
+
+/* a profile captured with manual control off must leave it off, whatever TDP does */
+static void test_restore_manual_off()
+{
+    slb_profile_t profile;
+    uint32_t manual = 1;
+
+    CHECK(slb_qc71_manual_control_set(0) == 0);
+    CHECK(slb_qc71_custom_tdp_set(20, 30, 40) == 0);
+    CHECK(slb_profile_capture(&profile) == 0);
+    CHECK(profile.fields & SLB_PROFILE_MANUAL_CONTROL);
+    CHECK(profile.manual_control == 0);
+
+    fake_resume(45, 54, 65);
+
+    CHECK(slb_profile_restore(&profile) == 0);
+    CHECK(slb_qc71_manual_control_get(&manual) == 0);
+    CHECK(manual == 0);
+}
+
+/* with manual control on, restore brings custom TDP back */
+static void test_restore_manual_on()
+{
+    slb_profile_t profile;
+    uint32_t manual = 0;
+    uint32_t pl1 = 0, pl2 = 0, pl4 = 0;
+
+    CHECK(slb_qc71_manual_control_set(1) == 0);
+    CHECK(slb_qc71_custom_tdp_set(20, 30, 40) == 0);
+    CHECK(slb_profile_capture(&profile) == 0);
+
+    CHECK(slb_qc71_manual_control_set(0) == 0);
+    fake_resume(45, 54, 65);
+
+    CHECK(slb_profile_restore(&profile) == 0);
+    CHECK(slb_qc71_manual_control_get(&manual) == 0);
+    CHECK(manual == 1);
+    CHECK(slb_qc71_custom_tdp_get(&pl1, &pl2, &pl4) == 0);
+    CHECK(pl1 == 20 and pl2 == 30 and pl4 == 40);
+}
+
+/* saving again with fewer fields drops the ones left out */
+static void test_resave_smaller()
+{
+    slb_profile_t profile;
+    slb_profile_t stored;
+
+    CHECK(slb_profile_capture(&profile) == 0);
+    CHECK(profile.fields & SLB_PROFILE_CUSTOM_TDP);
+    CHECK(slb_profile_set("resave", &profile) == 0);
+
+    profile.fields = SLB_PROFILE_BACKLIGHT | SLB_PROFILE_FN_LOCK;
+    CHECK(slb_profile_set("resave", &profile) == 0);
+
+    CHECK(slb_profile_get("resave", &stored) == 0);
+    CHECK(stored.fields == (SLB_PROFILE_BACKLIGHT | SLB_PROFILE_FN_LOCK));
+    CHECK(stored.backlight == profile.backlight and stored.fn_lock == profile.fn_lock);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        cerr<<"Usage: test-profile DIR"<<endl;
+        return 2;
+    }
+
+    string dir = argv[1];
+    database_entry_t* entry = database;
+
+    while (entry->model > 0 and fixture_name(entry) != "TITAN") {
+        entry++;
+    }
+
+    error_code ec;
+    filesystem::remove_all(dir, ec);
+
+    if (entry->model == 0 or fixture_create(dir, entry) != 0) {
+        cerr<<"Failed to create fixture under "<<dir<<endl;
+        return 2;
+    }
+
+    filesystem::create_directories(dir + "/var/lib/slimbook", ec);
+    slb_root_set(dir.c_str());
+
+    test_restore_manual_off();
+    test_restore_manual_on();
+    test_resave_smaller();
+
+    return failed;
+}
@@ -0,0 +1,328 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "timeline.h"
+#include "trace.h"
+#include "stats.h"
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include <unistd.h>
+
+using namespace std;
+
+typedef struct {
+    uint64_t start;
+    uint64_t duration;
+    const char* category;
+    const char* name;
+    int32_t status;
+    char detail[TIMELINE_DETAIL_SIZE];
+} timeline_event_t;
+
+/*
+  Single producer ring: owner thread pushes without locking, spans are
+  taken out, by any thread, only while holding timeline_mutex.
+*/
+typedef struct {
+    timeline_event_t events[TIMELINE_RING_EVENTS];
+    atomic<uint64_t> head;
+    atomic<uint64_t> tail;
+    pid_t tid;
+} timeline_ring_t;
+
+static atomic<bool> timeline_current(false);
+static mutex timeline_mutex;
+static FILE* timeline_out = nullptr;
+static bool timeline_first = true;
+static vector<timeline_ring_t*> timeline_rings;
+
+static __thread timeline_ring_t* timeline_ring = nullptr;
+
+/* writes a JSON string, paths may hold anything */
+static void _timeline_string(FILE* file, const char* str)
+{
+    fputc('"', file);
+
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' or *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if ((unsigned char)*c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        }
+        else {
+            fputc(*c, file);
+        }
+    }
+
+    fputc('"', file);
+}
+
+/* writes out pending spans of ring, caller holds timeline_mutex */
+static void _timeline_flush(timeline_ring_t* ring)
+{
+    uint64_t tail = ring->tail.load(memory_order_relaxed);
+    uint64_t head = ring->head.load(memory_order_acquire);
+
+    if (timeline_out == nullptr) {
+        ring->tail.store(head, memory_order_release);
+        return;
+    }
+
+    pid_t pid = getpid();
+
+    for (; tail != head; tail++) {
+        timeline_event_t* event = &ring->events[tail % TIMELINE_RING_EVENTS];
+
+        /* ts and dur are microseconds */
+        fprintf(timeline_out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,\"pid\":%d,\"tid\":%d,\"args\":{",
+            timeline_first ? "\n" : ",\n", event->name, event->category,
+            (unsigned long long)event->start / 1000, (unsigned long long)event->start % 1000,
+            (unsigned long long)event->duration / 1000, (unsigned long long)event->duration % 1000,
+            pid, ring->tid);
+
+        if (event->detail[0]) {
+            fputs("\"detail\":", timeline_out);
+            _timeline_string(timeline_out, event->detail);
+            fputc(',', timeline_out);
+        }
+
+        fprintf(timeline_out, "\"status\":%d}}", event->status);
+        timeline_first = false;
+    }
+
+    ring->tail.store(head, memory_order_release);
+}
+
+/* owns calling thread ring, writing it out on thread exit */
+class timeline_holder
+{
+    public:
+
+    timeline_ring_t* ring;
+
+    timeline_holder()
+    {
+        ring = new timeline_ring_t();
+        ring->tid = gettid();
+
+        lock_guard<mutex> lock(timeline_mutex);
+        timeline_rings.push_back(ring);
+    }
+
+    ~timeline_holder()
+    {
+        lock_guard<mutex> lock(timeline_mutex);
+
+        _timeline_flush(ring);
+        timeline_rings.erase(std::remove(timeline_rings.begin(), timeline_rings.end(), ring), timeline_rings.end());
+        delete ring;
+        timeline_ring = nullptr;
+    }
+};
+
+static timeline_ring_t* _timeline_thread()
+{
+    static thread_local timeline_holder holder;
+
+    timeline_ring = holder.ring;
+
+    return timeline_ring;
+}
+
+static void _timeline_exit()
+{
+    timeline_stop();
+}
+
+bool timeline_enabled()
+{
+    return timeline_current.load(memory_order_relaxed);
+}
+
+int timeline_start(const char* path)
+{
+    static bool registered = false;
+
+    timeline_stop();
+
+    lock_guard<mutex> lock(timeline_mutex);
+
+    FILE* file = fopen(path, "we");
+
+    if (!file) {
+        return errno;
+    }
+
+    /* drop spans pushed while previous timeline was being stopped */
+    for (timeline_ring_t* ring : timeline_rings) {
+        _timeline_flush(ring);
+    }
+
+    setvbuf(file, nullptr, _IOFBF, 1 << 16);
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+
+    timeline_out = file;
+    timeline_first = true;
+
+    if (!registered) {
+        atexit(_timeline_exit);
+        registered = true;
+    }
+
+    timeline_current = true;
+    stats_timeline(true);
+
+    return 0;
+}
+
+void timeline_stop()
+{
+    lock_guard<mutex> lock(timeline_mutex);
+
+    timeline_current = false;
+    stats_timeline(false);
+
+    if (!timeline_out) {
+        return;
+    }
+
+    for (timeline_ring_t* ring : timeline_rings) {
+        _timeline_flush(ring);
+    }
+
+    fputs("\n]}\n", timeline_out);
+    fclose(timeline_out);
+    timeline_out = nullptr;
+}
+
+/* at load, so public calls know whether to measure themselves from the very first one */
+static bool _timeline_env()
+{
+    const char* path = secure_getenv(SLB_TIMELINE_ENV);
+
+    if (path and path[0]) {
+        timeline_start(path);
+    }
+
+    return true;
+}
+
+static bool timeline_env_loaded = _timeline_env();
+
+void timeline_span(const char* category, const char* name, const char* detail, uint64_t start, uint64_t duration, int32_t status)
+{
+    timeline_ring_t* ring = timeline_ring ? timeline_ring : _timeline_thread();
+    uint64_t head = ring->head.load(memory_order_relaxed);
+
+    /* full, this thread writes its own spans out instead of dropping them */
+    if (head - ring->tail.load(memory_order_acquire) >= TIMELINE_RING_EVENTS) {
+        lock_guard<mutex> lock(timeline_mutex);
+        _timeline_flush(ring);
+    }
+
+    timeline_event_t* event = &ring->events[head % TIMELINE_RING_EVENTS];
+
+    event->start = start;
+    event->duration = duration;
+    event->category = category;
+    event->name = name;
+    event->status = status;
+    event->detail[0] = 0;
+
+    if (detail) {
+        size_t len = strlen(detail);
+
+        /* paths differ at their end */
+        if (len >= TIMELINE_DETAIL_SIZE) {
+            detail += len - (TIMELINE_DETAIL_SIZE - 1);
+        }
+
+        strncpy(event->detail, detail, TIMELINE_DETAIL_SIZE - 1);
+        event->detail[TIMELINE_DETAIL_SIZE - 1] = 0;
+    }
+
+    ring->head.store(head + 1, memory_order_release);
+}
+
+void timeline_access(uint8_t op, const char* key, uint64_t start, uint64_t duration, int32_t status)
+{
+    const char* category = TIMELINE_CAT_SYSFS;
+    const char* name;
+
+    switch (op) {
+        case TRACE_OP_READ:
+            name = "read";
+
+            if (strncmp(key, "/sys/firmware/dmi/", 18) == 0) {
+                category = TIMELINE_CAT_SMBIOS;
+            }
+        break;
+
+        case TRACE_OP_WRITE:
+            name = "write";
+        break;
+
+        case TRACE_OP_STAT:
+            name = "stat";
+        break;
+
+        case TRACE_OP_LIST:
+            name = "list";
+        break;
+
+        case TRACE_OP_LINK:
+            name = "readlink";
+        break;
+
+        case TRACE_OP_PCI_READ:
+            category = TIMELINE_CAT_PCI;
+            name = "config_read";
+        break;
+
+        case TRACE_OP_PCI_WRITE:
+            category = TIMELINE_CAT_PCI;
+            name = "config_write";
+        break;
+
+        case TRACE_OP_MEM:
+            category = TIMELINE_CAT_SMU;
+            name = "map";
+        break;
+
+        case TRACE_OP_CPUID:
+            category = TIMELINE_CAT_CPU;
+            name = "cpuid";
+        break;
+
+        default:
+            name = "access";
+    }
+
+    timeline_span(category, name, key, start, duration, status);
+}
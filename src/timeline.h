@@ -0,0 +1,62 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_TIMELINE_H
+#define SLB_TIMELINE_H
+
+#include <cstdint>
+
+/* Environment variable with a Chrome trace file to write spans to */
+#define SLB_TIMELINE_ENV "SLB_TIMELINE"
+
+/* spans buffered per thread before it has to write them out itself */
+#define TIMELINE_RING_EVENTS    8192
+
+/* span detail, ie: a sysfs path, longer ones keep their tail */
+#define TIMELINE_DETAIL_SIZE    72
+
+/* span categories */
+#define TIMELINE_CAT_API    "api"
+#define TIMELINE_CAT_SYSFS  "sysfs"
+#define TIMELINE_CAT_PCI    "pci"
+#define TIMELINE_CAT_SMU    "smu"
+#define TIMELINE_CAT_SMBIOS "smbios"
+#define TIMELINE_CAT_CPU    "cpu"
+
+/* Whether spans are being collected. SLB_TIMELINE is read at load, ignored by setuid callers */
+bool timeline_enabled();
+
+/* Starts writing Chrome trace event JSON to path, stopping any previous timeline. Returns 0 or errno */
+int timeline_start(const char* path);
+
+/* Writes out spans of all threads and closes the JSON document */
+void timeline_stop();
+
+/*
+  Adds a complete span to calling thread ring. category and name must be
+  static strings, detail is copied and may be nullptr. start is
+  CLOCK_MONOTONIC nanoseconds, status an errno shown as span argument.
+*/
+void timeline_span(const char* category, const char* name, const char* detail, uint64_t start, uint64_t duration, int32_t status);
+
+/* Same as above for a TRACE_OP_* access to key */
+void timeline_access(uint8_t op, const char* key, uint64_t start, uint64_t duration, int32_t status);
+
+#endif
@@ -0,0 +1,239 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "trace.h"
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+using namespace std;
+
+/* replay waits shorter than this spin, sleeping would overshoot them */
+#define TRACE_SPIN_NS 200000
+
+struct trace_entry_t
+{
+    int32_t status;
+    uint32_t duration;
+    string data;
+};
+
+static atomic<int> trace_current(TRACE_OFF);
+static mutex trace_mutex;
+static FILE* trace_out = nullptr;
+static map<pair<uint8_t,string>,deque<trace_entry_t>> trace_in;
+
+static void _trace_exit()
+{
+    trace_stop();
+}
+
+static bool _trace_env()
+{
+    const char* replay = secure_getenv(SLB_TRACE_REPLAY_ENV);
+    const char* record = secure_getenv(SLB_TRACE_RECORD_ENV);
+
+    if (replay) {
+        trace_start(TRACE_REPLAY, replay);
+    }
+    else if (record) {
+        trace_start(TRACE_RECORD, record);
+    }
+
+    return true;
+}
+
+int trace_mode()
+{
+    static bool loaded = _trace_env();
+
+    (void)loaded;
+
+    return trace_current.load(memory_order_relaxed);
+}
+
+uint64_t trace_clock()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int _trace_load(FILE* file)
+{
+    uint32_t header[2];
+
+    if (fread(header, sizeof(header), 1, file) != 1 or header[0] != TRACE_MAGIC or header[1] != TRACE_VERSION) {
+        return EINVAL;
+    }
+
+    trace_record_t record;
+
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        string key(record.key_size, 0);
+        trace_entry_t entry = {record.status, record.duration, string(record.size, 0)};
+
+        if ((record.key_size > 0 and fread(&key[0], record.key_size, 1, file) != 1) or
+            (record.size > 0 and fread(&entry.data[0], record.size, 1, file) != 1)) {
+            return EINVAL;
+        }
+
+        trace_in[{record.op, key}].push_back(std::move(entry));
+    }
+
+    return 0;
+}
+
+int trace_start(int mode, const char* path)
+{
+    static bool registered = false;
+
+    trace_stop();
+
+    lock_guard<mutex> lock(trace_mutex);
+
+    if (mode == TRACE_OFF) {
+        return 0;
+    }
+
+    FILE* file = fopen(path, mode == TRACE_RECORD ? "we" : "re");
+
+    if (!file) {
+        return errno;
+    }
+
+    if (mode == TRACE_REPLAY) {
+        int status = _trace_load(file);
+        fclose(file);
+
+        if (status != 0) {
+            trace_in.clear();
+            return status;
+        }
+    }
+    else {
+        uint32_t header[2] = {TRACE_MAGIC, TRACE_VERSION};
+
+        /* records are small, keep them off the hot path */
+        setvbuf(file, nullptr, _IOFBF, 1 << 16);
+        fwrite(header, sizeof(header), 1, file);
+        trace_out = file;
+    }
+
+    if (!registered) {
+        atexit(_trace_exit);
+        registered = true;
+    }
+
+    trace_current = mode;
+
+    return 0;
+}
+
+void trace_stop()
+{
+    lock_guard<mutex> lock(trace_mutex);
+
+    trace_current = TRACE_OFF;
+
+    if (trace_out) {
+        fclose(trace_out);
+        trace_out = nullptr;
+    }
+
+    trace_in.clear();
+}
+
+void trace_record(uint8_t op, const char* key, int32_t status, const void* data, size_t size, uint64_t duration)
+{
+    trace_record_t record;
+    size_t key_size = strlen(key);
+
+    record.op = op;
+    record.reserved = 0;
+    record.key_size = key_size > UINT16_MAX ? UINT16_MAX : key_size;
+    record.status = status;
+    record.size = size > UINT32_MAX ? UINT32_MAX : size;
+    record.duration = duration > UINT32_MAX ? UINT32_MAX : duration;
+
+    lock_guard<mutex> lock(trace_mutex);
+
+    if (!trace_out) {
+        return;
+    }
+
+    fwrite(&record, sizeof(record), 1, trace_out);
+    fwrite(key, record.key_size, 1, trace_out);
+
+    if (record.size > 0) {
+        fwrite(data, record.size, 1, trace_out);
+    }
+}
+
+bool trace_replay(uint8_t op, const char* key, int32_t* status, string* data)
+{
+    uint64_t start = trace_clock();
+    uint32_t duration;
+
+    {
+        lock_guard<mutex> lock(trace_mutex);
+        auto it = trace_in.find({op, key});
+
+        if (it == trace_in.end() or it->second.empty()) {
+            return false;
+        }
+
+        trace_entry_t& entry = it->second.front();
+
+        *status = entry.status;
+        duration = entry.duration;
+
+        if (data) {
+            *data = entry.data;
+        }
+
+        if (it->second.size() > 1) {
+            it->second.pop_front();
+        }
+    }
+
+    uint64_t deadline = start + duration;
+    uint64_t now = trace_clock();
+
+    if (deadline > now + TRACE_SPIN_NS) {
+        uint64_t sleep = deadline - now - TRACE_SPIN_NS;
+        struct timespec ts = {(time_t)(sleep / 1000000000), (long)(sleep % 1000000000)};
+
+        nanosleep(&ts, nullptr);
+    }
+
+    while (trace_clock() < deadline) {
+    }
+
+    return true;
+}
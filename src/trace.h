@@ -0,0 +1,215 @@
+/*
+Copyright (C) 2026 Slimbook <dev@slimbook.es>
+
+This file is part of libslimbook.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef SLB_TRACE_H
+#define SLB_TRACE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <sys/types.h>
+
+#include "timeline.h"
+
+/* Environment variables with a trace file to write or to serve hardware I/O from */
+#define SLB_TRACE_RECORD_ENV "SLB_TRACE_RECORD"
+#define SLB_TRACE_REPLAY_ENV "SLB_TRACE_REPLAY"
+
+#define TRACE_MAGIC     0x54424c53
+#define TRACE_VERSION   1
+
+/* modes, same values as SLB_TRACE_* */
+#define TRACE_OFF       0
+#define TRACE_RECORD    1
+#define TRACE_REPLAY    2
+
+/* traced operations, key is a system path unless noted */
+#define TRACE_OP_READ       1
+#define TRACE_OP_WRITE      2
+/* file exists, payload is empty */
+#define TRACE_OP_STAT       3
+/* directory listing, payload holds NUL terminated names */
+#define TRACE_OP_LIST       4
+#define TRACE_OP_LINK       5
+/* pci config space, key is config path@offset */
+#define TRACE_OP_PCI_READ   6
+#define TRACE_OP_PCI_WRITE  7
+/* /dev/mem page, key is physical address */
+#define TRACE_OP_MEM        8
+/* key is leaf, payload holds eax, ebx, ecx and edx */
+#define TRACE_OP_CPUID      9
+
+/*
+  Trace file is TRACE_MAGIC and TRACE_VERSION as u32, followed by one
+  record per access in host byte order:
+
+  u8 op, u8 reserved, u16 key size, i32 errno, u32 payload size,
+  u32 duration in nanoseconds, key bytes, payload bytes
+*/
+typedef struct trace_record_t {
+    uint8_t op;
+    uint8_t reserved;
+    uint16_t key_size;
+    int32_t status;
+    uint32_t size;
+    uint32_t duration;
+} trace_record_t;
+
+/* Gets current mode. First call reads SLB_TRACE_REPLAY or SLB_TRACE_RECORD, ignored by setuid callers */
+int trace_mode();
+
+/* Starts recording to or replaying from path, stopping any previous trace. Returns 0 or errno */
+int trace_start(int mode, const char* path);
+
+/* Flushes and closes current trace */
+void trace_stop();
+
+/* CLOCK_MONOTONIC nanoseconds */
+uint64_t trace_clock();
+
+/* Appends an access to the trace being recorded */
+void trace_record(uint8_t op, const char* key, int32_t status, const void* data, size_t size, uint64_t duration);
+
+/*
+  Serves next recorded access to key, after waiting as long as it took
+  originally. Last access to a key is served again once trace runs out
+  of them, as when polling a register. Returns false if key was never
+  recorded
+*/
+bool trace_replay(uint8_t op, const char* key, int32_t* status, std::string* data);
+
+/*
+  Runs a read of up to size bytes through the trace: proc does the actual
+  read, returning its length or -errno, and is not called when replaying.
+  Also adds a timeline span when one is being collected.
+  Returns length or -errno
+*/
+template<typename F>
+ssize_t traced_read(uint8_t op, const char* key, char* buf, size_t size, F proc)
+{
+    int mode = trace_mode();
+    bool timed = timeline_enabled();
+
+    if (mode == TRACE_OFF and !timed) {
+        return proc();
+    }
+
+    uint64_t start = trace_clock();
+    ssize_t len;
+
+    if (mode == TRACE_REPLAY) {
+        std::string data;
+        int32_t status;
+
+        if (!trace_replay(op, key, &status, &data)) {
+            len = -ENOENT;
+        }
+        else {
+            size_t count = data.size() < size ? data.size() : size;
+            data.copy(buf, count);
+
+            len = status != 0 ? -status : (ssize_t)count;
+        }
+    }
+    else {
+        len = proc();
+
+        if (mode == TRACE_RECORD) {
+            trace_record(op, key, len < 0 ? -len : 0, buf, len < 0 ? 0 : len, trace_clock() - start);
+        }
+    }
+
+    if (timed) {
+        timeline_access(op, key, start, trace_clock() - start, len < 0 ? -len : 0);
+    }
+
+    return len;
+}
+
+/* Same as above for writes and other calls with no output, proc returns 0 or errno */
+template<typename F>
+int traced_call(uint8_t op, const char* key, const void* data, size_t size, F proc)
+{
+    int mode = trace_mode();
+    bool timed = timeline_enabled();
+
+    if (mode == TRACE_OFF and !timed) {
+        return proc();
+    }
+
+    uint64_t start = trace_clock();
+    int32_t status;
+
+    if (mode == TRACE_REPLAY) {
+        if (!trace_replay(op, key, &status, nullptr)) {
+            status = ENOENT;
+        }
+    }
+    else {
+        status = proc();
+
+        if (mode == TRACE_RECORD) {
+            trace_record(op, key, status, data, size, trace_clock() - start);
+        }
+    }
+
+    if (timed) {
+        timeline_access(op, key, start, trace_clock() - start, status);
+    }
+
+    return status;
+}
+
+/* Same as above for calls producing a string, proc fills out and returns 0 or errno */
+template<typename F>
+int traced_string(uint8_t op, const char* key, std::string& out, F proc)
+{
+    int mode = trace_mode();
+    bool timed = timeline_enabled();
+
+    if (mode == TRACE_OFF and !timed) {
+        return proc();
+    }
+
+    uint64_t start = trace_clock();
+    int32_t status;
+
+    if (mode == TRACE_REPLAY) {
+        if (!trace_replay(op, key, &status, &out)) {
+            status = ENOENT;
+        }
+    }
+    else {
+        status = proc();
+
+        if (mode == TRACE_RECORD) {
+            trace_record(op, key, status, out.data(), out.size(), trace_clock() - start);
+        }
+    }
+
+    if (timed) {
+        timeline_access(op, key, start, trace_clock() - start, status);
+    }
+
+    return status;
+}
+
+#endif